@@ -0,0 +1,138 @@
+#include "benchmark.h"
+#include "cwordle.h"
+#include "parallel.h"
+#include "timing_reporter.h"
+#include <numeric>
+
+/************************************************************************
+ * single_threaded_best - while one of these exists, best() runs on a
+ * single thread. The max_threads setting is put back when it goes,
+ * however that happens.
+ ***********************************************************************/
+
+struct single_threaded_best
+{
+    int saved_threads = max_threads;
+    single_threaded_best()
+    {
+        max_threads = 1;
+    }
+    ~single_threaded_best()
+    {
+        max_threads = saved_threads;
+    }
+};
+
+/************************************************************************
+ * run - play a game for every answer, or if 'sample' is given, for
+ * that many answers spread evenly through the list.
+ ***********************************************************************/
+
+void benchmark::run(size_t sample)
+{
+    word_list answers = my_dict.allowed_size() > 0
+        ? word_list(my_dict, my_dict.get_allowed_bits())
+        : word_list(my_dict);
+    answers.begin();
+    vector<string_view> todo;
+    size_t count = sample > 0 ? std::min(sample, answers.size()) : answers.size();
+    for (size_t i : irange(0ul, count)) {
+        todo.emplace_back(my_dict[answers[i * answers.size() / count]].str());
+    }
+    my_stats = stats();
+    my_stats.threads = parallel::thread_count(todo.size());
+    vector<stats> partials(my_stats.threads);
+    auto start = high_resolution_clock::now();
+    {
+        single_threaded_best st;
+        parallel::for_chunks(todo.size(), my_stats.threads, 1,
+                             [&](size_t worker, size_t b, size_t e) {
+                                 for (size_t i : irange(b, e)) {
+                                     play(todo[i], partials[worker]);
+                                 }
+                             });
+    }
+    my_stats.wall_time = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count();
+    my_stats.guesses.assign(max_guesses + 1, 0);
+    for (const auto &p : partials) {
+        my_stats.games += p.games;
+        my_stats.lost += p.lost;
+        my_stats.total_guesses += p.total_guesses;
+        for (size_t g : irange(0ul, p.guesses.size())) {
+            my_stats.guesses[g] += p.guesses[g];
+        }
+        my_stats.turn_times.insert(my_stats.turn_times.end(), p.turn_times.begin(), p.turn_times.end());
+    }
+    std::sort(my_stats.turn_times.begin(), my_stats.turn_times.end());
+}
+
+/************************************************************************
+ * play - play one game, adding the result to the given stats. The
+ * guess is the best word, unless best() can't tell the remaining words
+ * apart (e.g. there is only one), in which case it is the first of them.
+ ***********************************************************************/
+
+void benchmark::play(const string_view &answer, stats &st) const
+{
+    cwordle game(&my_dict);
+    game.set_word(answer);
+    st.guesses.resize(max_guesses + 1);
+    while (game.size() < size_t(max_guesses)) {
+        auto start = high_resolution_clock::now();
+        auto result = game.best(1);
+        st.turn_times.push_back(duration_cast<nanoseconds>(high_resolution_clock::now() - start).count());
+        const wordle_word *guess = result.size() > 0 && result.begin()->value > 0
+            ? result.begin()->key
+            : &my_dict[game.remaining()[0]];
+        game.try_word(*guess);
+        if (guess->str()==answer) {
+            ++st.guesses[game.size()];
+            st.total_guesses += game.size();
+            break;
+        }
+    }
+    st.lost += game.get_last_result().str()!=answer;
+    ++st.games;
+}
+
+/************************************************************************
+ * percentile - return the time taken by the turn at the given
+ * percentile (0 to 100)
+ ***********************************************************************/
+
+float benchmark::percentile(float p) const
+{
+    const auto &tt = my_stats.turn_times;
+    if (tt.empty()) {
+        return 0;
+    }
+    return tt[std::min(tt.size() - 1, size_t(p / 100 * tt.size()))];
+}
+
+/************************************************************************
+ * report - return a description of the results of the last run
+ ***********************************************************************/
+
+string benchmark::report() const
+{
+    timing_reporter tr(true);
+    size_t won = my_stats.games - my_stats.lost;
+    string result = formatted("Played %d games in %s on %d threads\n",
+                              my_stats.games, tr.show_time(my_stats.wall_time), my_stats.threads);
+    result += formatted("Won %d, lost %d (%.2f%%), average %.3f guesses per game won\n",
+                        won, my_stats.lost,
+                        my_stats.games ? 100.0f * my_stats.lost / my_stats.games : 0.0f,
+                        won ? float(my_stats.total_guesses) / won : 0.0f);
+    result += "Guesses:";
+    for (size_t g : irange(1ul, my_stats.guesses.size())) {
+        result += formatted(" %d: %d", g, my_stats.guesses[g]);
+    }
+    result += formatted(" lost: %d\n", my_stats.lost);
+    const auto &tt = my_stats.turn_times;
+    float total = std::accumulate(tt.begin(), tt.end(), 0.0f);
+    result += formatted("%d turns, mean %s, 50%% %s, 90%% %s, 99%% %s, max %s\n", tt.size(),
+                        tr.show_time(tt.empty() ? 0 : total / tt.size()),
+                        tr.show_time(percentile(50)), tr.show_time(percentile(90)),
+                        tr.show_time(percentile(99)), tr.show_time(tt.empty() ? 0 : tt.back()));
+    return result;
+}
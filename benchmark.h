@@ -0,0 +1,52 @@
+#ifndef __BENCHMARK
+#define __BENCHMARK
+
+#include "types.h"
+#include "dictionary.h"
+
+/************************************************************************
+ * benchmark - measure how well and how fast the solver plays, by
+ * playing a game against every answer (the dictionary's allowed words,
+ * or all the words if there is no allowed list) and guessing whatever
+ * best() suggests each time, with the current settings (tree, cache,
+ * strict mode and so on).
+ *
+ * The games are shared out between threads. Each best() is then run on
+ * a single thread, so that the threads don't fight over the cores.
+ *
+ * The results are the number of games won in each number of guesses,
+ * the number lost, the wall time for the whole run and the time taken
+ * by each call to best(), from which the percentiles are reported.
+ ***********************************************************************/
+
+class benchmark
+{
+public:
+    struct stats
+    {
+        size_t games = 0;
+        size_t lost = 0;
+        U64 total_guesses = 0;          // for games won
+        vector<size_t> guesses;         // games won in [n] guesses
+        vector<float> turn_times;       // nS for each best(), sorted
+        float wall_time = 0;            // nS for the whole run
+        size_t threads = 0;
+    };
+private:
+    dictionary &my_dict;
+    stats my_stats;
+public:
+    benchmark(dictionary &dict)
+        : my_dict(dict) { };
+    void run(size_t sample=0);
+    const stats &get_stats() const
+    {
+        return my_stats;
+    }
+    string report() const;
+private:
+    void play(const string_view &answer, stats &st) const;
+    float percentile(float p) const;
+};
+
+#endif
@@ -0,0 +1,188 @@
+#include "best_cache.h"
+#include <cstring>
+
+/************************************************************************
+ * Constructor - the config covers the dictionary contents and the
+ * mode, which between them determine the results
+ ***********************************************************************/
+
+best_cache::best_cache(const dictionary &dict)
+    : my_dict(dict), strict(strict_mode), dict_size(dict.size()), allowed_size(dict.allowed_size())
+{
+    config = fnv_hash(&strict, sizeof(strict), dict.fingerprint());
+}
+
+/************************************************************************
+ * open - load any entries for our config from the file, then keep it
+ * open to append new ones. Return false if the file can't be written.
+ *
+ * Later records replace earlier ones for the same config and key.
+ * Loading stops at anything which doesn't make sense, such as a record
+ * cut short by a crash. If any records were replaced or dropped
+ * (including ones of ours for states we no longer keep), the file is
+ * rewritten with just the others, so it doesn't keep growing.
+ ***********************************************************************/
+
+bool best_cache::open(const string &filename)
+{
+    std::lock_guard<mutex> lock(my_mutex);
+    vector<pair<record_header, vector<char>>> records;
+    map<pair<U64, key_t>, size_t> latest;
+    size_t read_count = 0;
+    {
+        std::ifstream istr(filename, std::ios::binary);
+        record_header h;
+        while (istr.read(reinterpret_cast<char*>(&h), sizeof(h))) {
+            if (h.count > h.requested || h.count > max_record_count) {
+                break;
+            }
+            vector<char> data(h.count * sizeof(cache_entry::result_t));
+            if (!istr.read(data.data(), data.size())) {
+                break;
+            }
+            ++read_count;
+            auto [iter, added] = latest.try_emplace({ h.config, h.key }, records.size());
+            if (added) {
+                records.emplace_back(h, std::move(data));
+            } else {
+                records[iter->second] = { h, std::move(data) };
+            }
+        }
+    }
+    auto is_ours = [&](const record_header &h) { return h.config==config; };
+    for (auto &r : records) {
+        if (is_ours(r.first)) {
+            cache_entry e;
+            e.requested = r.first.requested;
+            e.results.resize(r.first.count);
+            memcpy(e.results.data(), r.second.data(), r.second.size());
+            if (std::all_of(e.results.begin(), e.results.end(),
+                            [&](const auto &res){ return res.index < my_dict.size(); })) {
+                entries[r.first.key] = std::move(e);
+            }
+        }
+    }
+    std::erase_if(entries, [&](const auto &e) { return !covers_locked(e.first); });
+    std::erase_if(records, [&](const auto &r) { return is_ours(r.first) && !entries.contains(r.first.key); });
+    if (records.size() < read_count && !rewrite(filename, records)) {
+        return false;
+    }
+    file.open(filename, std::ios::binary | std::ios::app);
+    return file.good();
+}
+
+/************************************************************************
+ * rewrite - replace the file with just the given records, writing a
+ * new file and renaming it over the old one so that the file is never
+ * left half written
+ ***********************************************************************/
+
+bool best_cache::rewrite(const string &filename, const vector<pair<record_header, vector<char>>> &records)
+{
+    string temp = filename + ".tmp";
+    {
+        std::ofstream ostr(temp, std::ios::binary | std::ios::trunc);
+        for (const auto &r : records) {
+            ostr.write(reinterpret_cast<const char*>(&r.first), sizeof(r.first));
+            ostr.write(r.second.data(), r.second.size());
+        }
+        if (!ostr.good()) {
+            return false;
+        }
+    }
+    return std::rename(temp.c_str(), filename.c_str())==0;
+}
+
+/************************************************************************
+ * covers - return whether the cache keeps the given key: the empty
+ * state, and the states after each of the best opener_count openers.
+ * Until the empty state has been seen we don't know what those are.
+ ***********************************************************************/
+
+bool best_cache::covers(key_t key) const
+{
+    std::lock_guard<mutex> lock(my_mutex);
+    return covers_locked(key);
+}
+
+bool best_cache::covers_locked(key_t key) const
+{
+    if (key==empty_key) {
+        return true;
+    }
+    auto iter = entries.find(empty_key);
+    if (iter==entries.end()) {
+        return false;
+    }
+    const auto &openers = iter->second.results;
+    word_index_t guess = key >> 32;
+    return std::any_of(openers.begin(), openers.begin() + std::min(opener_count, openers.size()),
+                       [&](const auto &r){ return r.index==guess; });
+}
+
+/************************************************************************
+ * has_openers - return whether the entry for the empty state is there
+ * and was built for at least opener_count results. If not, the caller
+ * should call best() for that many in the empty state to fill it in.
+ ***********************************************************************/
+
+bool best_cache::has_openers() const
+{
+    std::lock_guard<mutex> lock(my_mutex);
+    auto iter = entries.find(empty_key);
+    return !valid() || (iter != entries.end() && iter->second.requested >= opener_count);
+}
+
+/************************************************************************
+ * find - return the saved results for a key, if we have them and
+ * they are good for how_many results
+ ***********************************************************************/
+
+optional<cwordle::result_list_t> best_cache::find(key_t key, size_t how_many) const
+{
+    optional<cwordle::result_list_t> result;
+    std::lock_guard<mutex> lock(my_mutex);
+    if (valid()) {
+        auto iter = entries.find(key);
+        if (iter != entries.end() && iter->second.requested >= how_many) {
+            result = cwordle::result_list_t(how_many);
+            for (const auto &r : iter->second.results) {
+                if (result->size() >= how_many) {
+                    break;
+                }
+                result->insert(&my_dict[r.index], r.score);
+            }
+        }
+    }
+    return result;
+}
+
+/************************************************************************
+ * insert - save the results for a key, unless it isn't one we keep or
+ * we already have them for as many results, and append them to the file
+ ***********************************************************************/
+
+void best_cache::insert(key_t key, size_t how_many, const cwordle::result_list_t &results)
+{
+    std::lock_guard<mutex> lock(my_mutex);
+    auto iter = entries.find(key);
+    if (!valid() || !covers_locked(key) || (iter != entries.end() && iter->second.requested >= how_many)) {
+        return;
+    }
+    cache_entry e;
+    e.requested = how_many;
+    for (const auto &r : results) {
+        auto idx = my_dict.index_of(*r.key);
+        if (!idx) {
+            return;
+        }
+        e.results.push_back({ idx.value(), r.value });
+    }
+    if (file.is_open()) {
+        record_header h = { config, key, e.requested, U32(e.results.size()) };
+        file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        file.write(reinterpret_cast<const char*>(e.results.data()), e.results.size() * sizeof(e.results[0]));
+        file.flush();
+    }
+    entries[key] = std::move(e);
+}
@@ -0,0 +1,103 @@
+#ifndef __BEST_CACHE
+#define __BEST_CACHE
+
+#include "types.h"
+#include "cwordle.h"
+#include <fstream>
+#include <unordered_map>
+
+/************************************************************************
+ * best_cache - saved results of cwordle::best for the states at the
+ * start of a game, kept in a file so they survive from one run to
+ * the next.
+ *
+ * For a given dictionary and mode, best() in the empty state always
+ * gives the same answer, and it is by far the most expensive call
+ * since every word is scored against the whole dictionary. The same
+ * goes, less expensively, for each state after one guess, which is
+ * identified by the guess and its match code.
+ *
+ * Only the states after one of the best few openers (opener_count of
+ * them, as given by the entry for the empty state) are kept: these are
+ * the ones most games go through, and keeping every first guess anyone
+ * plays would make the file grow without bound.
+ *
+ * Entries are filled in as best() is called, and each new one is
+ * appended to the file. The entry for the empty state is worked out
+ * when the cache is opened, if it isn't there already, since until it
+ * is the others can't be kept. Each record in the file carries the config
+ * (a hash of the dictionary fingerprint and strict_mode), so one file
+ * can be shared by different languages, lengths and modes; records for
+ * other configs are ignored when loading. If the dictionary changes
+ * after the cache is opened, the cache is bypassed. A record replaces
+ * any earlier one for the same config and key, and if the file holds
+ * records which have been replaced, it is rewritten without them when
+ * it is opened.
+ *
+ * An entry is used if it was built for at least as many results as
+ * are asked for.
+ *
+ * The cache is shared between games and is thread safe.
+ ***********************************************************************/
+
+class best_cache
+{
+public:
+    typedef dictionary::word_index_t word_index_t;
+    typedef U64 key_t;
+    static constexpr key_t empty_key = ~0ull;
+    static constexpr size_t opener_count = 10;
+private:
+    struct cache_entry
+    {
+        // Written to and read from the file as it is, so a plain struct
+        struct result_t
+        {
+            word_index_t index;
+            float score;
+        };
+        U32 requested = 0;
+        vector<result_t> results;
+    };
+    static constexpr U32 max_record_count = 1 << 16;
+    struct record_header
+    {
+        U64 config;
+        key_t key;
+        U32 requested;
+        U32 count;
+    };
+    const dictionary &my_dict;
+    U64 config;
+    bool strict;
+    size_t dict_size;
+    size_t allowed_size;
+    std::unordered_map<key_t, cache_entry> entries;
+    std::ofstream file;
+    mutable mutex my_mutex;
+public:
+    best_cache(const dictionary &dict);
+    bool open(const string &filename);
+    size_t size() const
+    {
+        std::lock_guard<mutex> lock(my_mutex);
+        return entries.size();
+    }
+    bool covers(key_t key) const;
+    bool has_openers() const;
+    optional<cwordle::result_list_t> find(key_t key, size_t how_many) const;
+    void insert(key_t key, size_t how_many, const cwordle::result_list_t &results);
+    static key_t make_key(word_index_t guess, U32 code)
+    {
+        return (key_t(guess) << 32) | code;
+    }
+private:
+    bool covers_locked(key_t key) const;
+    bool rewrite(const string &filename, const vector<pair<record_header, vector<char>>> &records);
+    bool valid() const
+    {
+        return my_dict.size()==dict_size && my_dict.allowed_size()==allowed_size && strict==strict_mode;
+    }
+};
+
+#endif
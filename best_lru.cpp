@@ -0,0 +1,102 @@
+#include "best_lru.h"
+
+/************************************************************************
+ * find - look for results for the key, counting a hit or a miss. A hit
+ * moves the entry to the front of the list.
+ ***********************************************************************/
+
+optional<cwordle::result_list_t> best_lru::find(U64 key, size_t list_size, size_t how_many)
+{
+    optional<cwordle::result_list_t> result;
+    std::lock_guard<mutex> lock(my_mutex);
+    auto iter = index.find(key);
+    if (iter != index.end()
+        && iter->second->list_size==list_size
+        && iter->second->requested >= how_many) {
+        lru.splice(lru.begin(), lru, iter->second);
+        result = cwordle::result_list_t(how_many);
+        for (const auto &r : iter->second->results) {
+            if (result->size() >= how_many) {
+                break;
+            }
+            result->insert(&my_dict[r.first], r.second);
+        }
+        ++hits;
+    } else {
+        ++misses;
+    }
+    return result;
+}
+
+/************************************************************************
+ * insert - add the results for a key, replacing any existing entry, and
+ * then discard old entries if we are over the memory limit
+ ***********************************************************************/
+
+void best_lru::insert(U64 key, size_t list_size, size_t how_many, const cwordle::result_list_t &results)
+{
+    entry e{ key, list_size, how_many, {} };
+    e.results.reserve(results.size());
+    for (const auto &r : results) {
+        auto idx = my_dict.index_of(*r.key);
+        if (!idx) {
+            return;
+        }
+        e.results.emplace_back(idx.value(), r.value);
+    }
+    std::lock_guard<mutex> lock(my_mutex);
+    if (e.memory() > memory_limit) {
+        return;
+    }
+    auto iter = index.find(key);
+    if (iter != index.end()) {
+        memory_used -= iter->second->memory();
+        lru.erase(iter->second);
+    }
+    memory_used += e.memory();
+    lru.push_front(std::move(e));
+    index[key] = lru.begin();
+    trim();
+}
+
+/************************************************************************
+ * get_stats - return the counters and memory use
+ ***********************************************************************/
+
+best_lru::stats best_lru::get_stats() const
+{
+    std::lock_guard<mutex> lock(my_mutex);
+    stats result;
+    result.hits = hits;
+    result.misses = misses;
+    result.entries = lru.size();
+    result.memory_used = memory_used;
+    result.memory_limit = memory_limit;
+    return result;
+}
+
+/************************************************************************
+ * clear - discard all entries
+ ***********************************************************************/
+
+void best_lru::clear()
+{
+    std::lock_guard<mutex> lock(my_mutex);
+    lru.clear();
+    index.clear();
+    memory_used = 0;
+}
+
+/************************************************************************
+ * trim - discard the least recently used entries until we are
+ * within the memory limit. The lock must be held.
+ ***********************************************************************/
+
+void best_lru::trim()
+{
+    while (memory_used > memory_limit && !lru.empty()) {
+        memory_used -= lru.back().memory();
+        index.erase(lru.back().key);
+        lru.pop_back();
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef __BEST_LRU
+#define __BEST_LRU
+
+#include "types.h"
+#include "cwordle.h"
+#include <list>
+#include <unordered_map>
+
+/************************************************************************
+ * best_lru - remembers recent results of cwordle::best, shared by all
+ * games in the process.
+ *
+ * Different games often reach the same set of remaining words, for
+ * example after the same popular opener gets the same feedback, and
+ * best() then gives the same answer. Entries are keyed by a hash of
+ * the remaining word list, together with the strict mode constraint if
+ * there is one (see cwordle::best_lru_key). The list size is kept with
+ * the entry as a check against hash collisions.
+ *
+ * The least recently used entries are discarded to keep the memory
+ * used within the given limit. An entry is used if it was built for at
+ * least as many results as are asked for.
+ *
+ * It is thread safe, and counts hits and misses.
+ ***********************************************************************/
+
+class best_lru
+{
+public:
+    typedef dictionary::word_index_t word_index_t;
+    struct stats
+    {
+        U64 hits = 0;
+        U64 misses = 0;
+        size_t entries = 0;
+        size_t memory_used = 0;
+        size_t memory_limit = 0;
+    };
+private:
+    struct entry
+    {
+        U64 key;
+        size_t list_size;
+        size_t requested;
+        vector<pair<word_index_t, float>> results;
+        size_t memory() const
+        {
+            return entry_overhead + results.capacity() * sizeof(results[0]);
+        }
+    };
+    typedef std::list<entry> lru_list_t;
+    static constexpr size_t entry_overhead = sizeof(entry) + 64;  // list and map nodes
+    const dictionary &my_dict;
+    lru_list_t lru;                     // most recently used first
+    std::unordered_map<U64, lru_list_t::iterator> index;
+    size_t memory_limit;
+    size_t memory_used = 0;
+    U64 hits = 0;
+    U64 misses = 0;
+    mutable mutex my_mutex;
+public:
+    best_lru(const dictionary &dict, size_t limit)
+        : my_dict(dict), memory_limit(limit) { };
+    optional<cwordle::result_list_t> find(U64 key, size_t list_size, size_t how_many);
+    void insert(U64 key, size_t list_size, size_t how_many, const cwordle::result_list_t &results);
+    stats get_stats() const;
+    void clear();
+private:
+    void trim();
+};
+
+#endif
@@ -3,7 +3,9 @@
 #include "tests.h"
 #include "timing_reporter.h"
 #include "wordle_word.h"
-#include "timers.h"
+#include "instrument.h"
+#include "best_lru.h"
+#include "benchmark.h"
 #include <boost/algorithm/string.hpp>
 #include <regex>
 
@@ -16,8 +18,8 @@ extern bool load_dict();
  * The singleton commands object provides the user interface to the cwordle object,
  * which is where all the real work happens.
  *
- * It also manages and reports the timing_reporter objects which are
- * used to report the time spent in critical algorithms.
+ * With --time, it also reports the time spent in critical algorithms
+ * during each command, from the instrument counters.
  ***********************************************************************/
 
 /************************************************************************
@@ -25,11 +27,13 @@ extern bool load_dict();
  ***********************************************************************/
 
 KEYWORDS(command_list)
-KEYWORD("best", "b", do_best, "show best word(s) to filter remaining words")
+KEYWORD("bench", "bench", do_bench, "play a game for every answer (or 'bench n' for a sample of n) and report the results")
+KEYWORD("best", "b", do_best, "show best word(s) to filter remaining words ('best [n] ahead [mS]' to look two guesses ahead, 'best [n] within mS' to limit the time)")
 KEYWORD("entropy", "ent", do_entropy, "show entropy for a word against current remaining")
 KEYWORD("exit", "ex", do_exit, "exit cwordle")
 KEYWORD("explain", "exp", do_explain, "explain how a word is analysed")
 KEYWORD("help", "h", do_help, "show help text")
+KEYWORD("memo", "memo", do_memo, "show statistics for remembered best word results")
 KEYWORD("new", "n", do_new, "select a new random word")
 KEYWORD("recap", "rec", do_recap, "recap worsd tried so far")
 KEYWORD("remaining", "rem", do_remaining, "show remaining matching words")
@@ -67,9 +71,9 @@ bool commands::do_command(const string &line)
 {
     bool result = true;
     my_line = rest_of_line = line;
-    timers::entropy_timer.reset();
-    timers::match_timer.reset();
-    timers::conforms_timer.reset();
+    if (show_timing) {
+        timing_start = instrument::collect();
+    }
     if (!line.empty()) {
         try {
             string cmd = next_arg();
@@ -96,27 +100,67 @@ bool commands::do_command(const string &line)
     return result;
 }
 
+/************************************************************************
+ * do_bench - play a game for every answer, or for a sample of them
+ * if a number is given, and report how well the solver did.
+ ***********************************************************************/
+
+void commands::do_bench()
+{
+    size_t sample = next_arg_int(true).value_or(0);
+    benchmark bench(get_dict());
+    bench.run(sample);
+    cout << styled_text(bench.report(), output_color);
+}
+
 /************************************************************************
  * do_best - find the best word given the esults we have had so far.
+ * If followed by 'ahead', look two guesses ahead, optionally with
+ * a time limit in mS other than the --lookahead-time option. If
+ * followed by 'within' and a time limit in mS, show the best words
+ * found in that time.
+ *
+ * The words are shown in the order given, which is best first but not
+ * always by value: see cwordle::with_tree_guess and best_lookahead.
  ***********************************************************************/
 
 void commands::do_best()
 {
-    auto how_many = next_arg_int(true);
+    optional<int> how_many;
+    optional<int> budget;
+    string mode = next_arg(true);
+    if (!mode.empty() && mode != "ahead" && mode != "within") {
+        try {
+            how_many = lexical_cast<int>(mode);
+        } catch (const std::exception &exc) {
+            throw syntax_exception("'%s' is not a valid integer", mode);
+        }
+        mode = next_arg(true);
+    }
+    if (mode=="ahead") {
+        budget = next_arg_int(true);
+    } else if (mode=="within") {
+        budget = next_arg_int();
+    } else if (!mode.empty()) {
+        throw syntax_exception("Expected 'ahead' or 'within' but found '%s'", mode);
+    }
     check_finished();
-    auto result = the_wordle->best(how_many.value_or(1));
-    std::multimap<float, string> result_map;
+    bool complete = true;
+    auto result = mode=="ahead"
+        ? the_wordle->best_lookahead(how_many.value_or(1), options["lookahead-width"].as<int>(),
+                                     budget.value_or(options["lookahead-time"].as<int>()), complete)
+        : the_wordle->best(how_many.value_or(1), budget.value_or(0), complete);
     for (const auto &r : result) {
         if (r.value > 0) {
-            result_map.insert(std::pair(r.value, r.key->str()));
+            cout << styled_text(formatted("%-7s %.3f", r.key->str(), r.value), output_color) << "\n";
         }
     }
-    for (auto r2=result_map.rbegin(); r2!=result_map.rend(); ++r2) {
-        cout << styled_text(formatted("%-7s %.3f", r2->second, r2->first), output_color) << "\n";
+    if (!complete) {
+        cout << styled_text("Out of time, not all words were tried\n", output_color);
     }
     if (show_timing) {
-        display_time(timers::match_timer, "Match: ");
-        display_time(timers::entropy_timer, "Entropy: ");
+        display_time(instrument::match, "Match: ");
+        display_time(instrument::entropy, "Entropy: ");
     }
 }
 
@@ -178,6 +222,24 @@ void commands::do_help()
     }
 }
 
+/************************************************************************
+ * do_memo - show the hit and miss counts and memory use of the
+ * best_lru
+ ***********************************************************************/
+
+void commands::do_memo()
+{
+    if (the_best_lru) {
+        auto st = the_best_lru->get_stats();
+        cout << styled_text(formatted("%d hits, %d misses, %d entries using %d of %d KB",
+                                      st.hits, st.misses, st.entries,
+                                      st.memory_used / 1024, st.memory_limit / 1024),
+                            output_color) << "\n";
+    } else {
+        cout << styled_text("Best word results are not being remembered\n", output_color);
+    }
+}
+
 /************************************************************************
  * do_new - choose a new random word
  ***********************************************************************/
@@ -313,7 +375,7 @@ void commands::do_try()
         }
     }
     if (show_timing) {
-        display_time(timers::conforms_timer, "Conforms: ");
+        display_time(instrument::conforms, "Conforms: ");
     }
 }
 
@@ -456,12 +518,17 @@ dictionary &commands::get_dict()
 }
 
 /************************************************************************
- * display_time - display the result of a timming_reporter
+ * display_time - display the time counted by an instrument counter
+ * during this command, per word if it counts words, else per call
  ***********************************************************************/
 
-void commands::display_time(timing_reporter &timer, const string &label)
+void commands::display_time(instrument::counter c, const string &label)
 {
-    string r = timer.report("", label);
+    auto t = (instrument::collect() - timing_start)[c];
+    U64 count = t.items ? t.items : t.calls;
+    timing_reporter tr(true);
+    string r = formatted("%s%d %sin %s, %s each\n", label, count, t.items ? "words " : "",
+                         tr.show_time(t.ns), tr.show_time(count ? t.ns / count : 0));
     cout << styled_text(r, styled_text::deep_blue, styled_text::color_none, styled_text::italic);
 }
 
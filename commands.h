@@ -5,6 +5,7 @@
 #include "cwordle.h"
 #include "formatted.h"
 #include "dictionary.h"
+#include "instrument.h"
 #include <boost/algorithm/string/predicate.hpp>
 
 class timing_reporter;
@@ -66,6 +67,7 @@ private:
     string rest_of_line;
     string cur_arg;
     bool show_timing = false;
+    instrument::totals timing_start;
 public:
     commands();
     bool do_command(const string &line);
@@ -74,11 +76,13 @@ public:
         show_timing = t;
     }
 public:
+    void do_bench();
     void do_best();
     void do_entropy();
     void do_exit();
     void do_explain();
     void do_help();
+    void do_memo();
     void do_new();
     void do_recap();
     void do_remaining();
@@ -98,7 +102,7 @@ private:
     void check_started() const;
     void check_finished();
     dictionary &get_dict();
-    void display_time(timing_reporter &timer, const string &label);
+    void display_time(instrument::counter c, const string &label);
     void new_word();
 };
 
@@ -1,6 +1,13 @@
 #include "cwordle.h"
+#include "best_cache.h"
+#include "best_lru.h"
+#include "decision_tree.h"
 #include "random.h"
 #include "partial_sorted_list.h"
+#include "parallel.h"
+#include <numeric>
+
+const size_t best_chunk_size = 64;
 
 /************************************************************************
  * A cwordle object tracks the state of matching successive words
@@ -8,6 +15,13 @@
  * it tracks the match_target(combined word and match_result),
  * and the list of still-permissible words.
  *
+ * The words still permissible after each guess are kept in a
+ * word_bitset_stack, one bit per dictionary word, so the history of a
+ * game takes a fixed amount of memory per guess, allocated once when
+ * the game is made. Only the current list is also held as a word_list.
+ * Undo pops the stack and makes the list again from the new top, and
+ * clear just empties it.
+ *
  * The functions are called form the commands object, in response
  * to user-entered commands.
  ***********************************************************************/
@@ -44,22 +58,362 @@ bool cwordle::load_file_allowed(const string &filename)
 /************************************************************************
  * best - return the words that give the best entropy amongst
  * the remaining words.
+ *
+ * Each candidate word is independent, so the dictionary is split
+ * into chunks which are shared out between max_threads threads.
+ * Each thread keeps its own result list, and these are merged at
+ * the end.
+ *
+ * If there is a decision tree which covers the guesses so far, the
+ * tree's next guess comes first. If only one word is asked for that is
+ * all there is to do, otherwise the rest are the best of the others,
+ * found as below (see with_tree_guess).
+ *
+ * At the start of a game, and after the first guess if it was one of
+ * the top openers, the results are looked for in (and else saved to)
+ * the_best_cache, if there is one.
+ * Otherwise they are looked for in the_best_lru, shared with other
+ * games, if there is one.
+ *
+ * If 'budget' is non-zero, the search stops after that many mS and
+ * returns the best words found so far, with 'complete' false. To make
+ * the most of the time, the words are tried in the order given by
+ * candidate_order, so those likely to do well come first. Incomplete
+ * results are not cached.
+ *
+ * With --incremental, the entropies come from an entropy_tracker,
+ * which is kept up to date with the word list rather than counting
+ * every histogram afresh.
  ***********************************************************************/
 
 cwordle::result_list_t cwordle::best(size_t how_many)
 {
+    bool complete;
+    return best(how_many, 0, complete);
+}
+
+cwordle::result_list_t cwordle::best(size_t how_many, int budget, bool &complete)
+{
+    auto tree_guess = the_decision_tree ? the_decision_tree->find(results) : std::nullopt;
+    if (tree_guess && how_many==1) {
+        complete = true;
+        return tree_guess.value();
+    }
+    result_list_t result = best_search(how_many, budget, complete);
+    return tree_guess ? with_tree_guess(tree_guess.value(), result, how_many) : result;
+}
+
+/************************************************************************
+ * best_search - the search for best, leaving out the decision tree
+ ***********************************************************************/
+
+cwordle::result_list_t cwordle::best_search(size_t how_many, int budget, bool &complete)
+{
+    auto deadline = steady_clock::now() + milliseconds(budget);
+    complete = true;
+    optional<U64> key = std::nullopt;
+    if (the_best_cache) {
+        key = best_cache_key();
+    }
+    if (key) {
+        if (auto cached = the_best_cache->find(key.value(), how_many)) {
+            return cached.value();
+        }
+    }
+    const word_list &wl = current_list();
+    optional<U64> lru_key;
+    if (the_best_lru && !key) {
+        lru_key = best_lru_key(wl);
+        if (auto cached = the_best_lru->find(lru_key.value(), wl.size(), how_many)) {
+            return cached.value();
+        }
+    }
+    auto *r = strict_mode && !empty() ? &get_last_result() : NULL;
+    const auto &words = my_dict.get_words();
+    size_t threads = parallel::thread_count(words.size() / best_chunk_size);
+    vector<result_list_t> partials(threads, result_list_t(how_many));
+    wl.begin();                 // fill it now, rather than racing to do so in the threads
+    vector<dictionary::word_index_t> order;
+    if (budget > 0) {
+        order = candidate_order(wl);
+    }
+    if (incremental_entropy && entropy_tracker::usable(my_dict)) {
+        if (!tracker) {
+            tracker = std::make_unique<entropy_tracker>(my_dict);
+        }
+        tracker->sync(wl);
+    } else {
+        tracker.reset();
+    }
+    std::atomic<bool> expired(false);
+    parallel::for_chunks(words.size(), threads, best_chunk_size,
+                         [&](size_t worker, size_t b, size_t e) {
+                             if (budget > 0 && (expired || steady_clock::now() > deadline)) {
+                                 expired = true;
+                                 return;
+                             }
+                             for (size_t i : irange(b, e)) {
+                                 dictionary::word_index_t idx = order.empty() ? i : order[i];
+                                 const wordle_word &w = words[idx];
+                                 if (r==NULL || r->conforms_exact(w.str())) {
+                                     partials[worker].insert(&w, tracker ? tracker->entropy(idx) : wl.entropy(w));
+                                 }
+                             }
+                         });
     result_list_t result(how_many);
-    const word_list &wl = word_lists.empty() ? all_my_words : word_lists.back();
-    auto *r = strict_mode && !the_wordle->empty() ? &the_wordle->get_last_result() : NULL;
-    for (const auto &w : my_dict.get_words()) {
-        if (r==NULL || r->conforms_exact(w.str())) {
-            float e = wl.entropy(w);
-            result.insert(&w, e);
+    for (const auto &p : partials) {
+        result.merge(p);
+    }
+    complete = !expired;
+    if (!complete) {
+        return result;
+    }
+    if (key) {
+        the_best_cache->insert(key.value(), how_many, result);
+    } else if (lru_key) {
+        the_best_lru->insert(lru_key.value(), wl.size(), how_many, result);
+    }
+    return result;
+}
+
+/************************************************************************
+ * with_tree_guess - return the decision tree's guess followed by the
+ * words found by the search, in order, leaving the tree's guess out
+ * if it is amongst them.
+ *
+ * The tree's guess is put first even if its score is lower, since
+ * the tree is a better strategy than following the scores. The list
+ * is filled in order and never gets full enough to be sorted again,
+ * so it keeps that order.
+ ***********************************************************************/
+
+cwordle::result_list_t cwordle::with_tree_guess(const result_list_t &tree_guess, const result_list_t &found,
+                                                size_t how_many) const
+{
+    result_list_t result(how_many);
+    const best_result_t &guess = *tree_guess.begin();
+    result.insert(guess.key, guess.value);
+    for (const auto &r : found) {
+        if (result.size() >= how_many) {
+            break;
+        }
+        if (r.key != guess.key) {
+            result.insert(r.key, r.value);
         }
     }
     return result;
 }
 
+/************************************************************************
+ * candidate_order - return the indices of all the dictionary words,
+ * in the order best should try them when it may run out of time.
+ * Each word is scored by the number of words in the list containing
+ * each of its letters, summed over its distinct letters. This is a
+ * cheap stand in for entropy: words made of common letters split the
+ * list most evenly.
+ ***********************************************************************/
+
+vector<dictionary::word_index_t> cwordle::candidate_order(const word_list &wl) const
+{
+    const U32 *all_letters = my_dict.get_view().get_all_letters();
+    array<U32, 32> letter_counts = {};
+    for (dictionary::word_index_t w : wl) {
+        for (U32 m = all_letters[w]; m; m &= m - 1) {
+            ++letter_counts[__builtin_ctz(m)];
+        }
+    }
+    vector<U32> scores(my_dict.size());
+    for (size_t i : irange(0ul, my_dict.size())) {
+        for (U32 m = all_letters[i]; m; m &= m - 1) {
+            scores[i] += letter_counts[__builtin_ctz(m)];
+        }
+    }
+    vector<dictionary::word_index_t> result(my_dict.size());
+    std::iota(result.begin(), result.end(), 0);
+    std::stable_sort(result.begin(), result.end(),
+                     [&](dictionary::word_index_t a, dictionary::word_index_t b){ return scores[a] > scores[b]; });
+    return result;
+}
+
+/************************************************************************
+ * best_lookahead - as best, but looking two guesses ahead. Each of
+ * the top 'width' words by entropy is scored again by the entropy it
+ * gives plus the expected entropy of the best follow-up guess once
+ * its result is known:
+ *
+ *   score(g) = H(g) + sum over results r of p(r) * max over g2 of H(g2 | r)
+ *
+ * Results which solve the game or leave only one word need no
+ * follow-up. In strict mode the follow-ups must conform to the result,
+ * as for best. The candidates are shared out between threads.
+ *
+ * For a result leaving n words, no follow-up can give more than
+ * log(n), so a candidate can't score more than its score so far plus
+ * that much for each result still to do. The results are done largest
+ * first, and once this can't beat the bound of the (full) result list
+ * the candidate is dropped. Likewise the search for a follow-up stops
+ * when one reaches log(n).
+ *
+ * Scoring stops 'budget' mS after the start, and candidates not done
+ * by then are left out, with 'complete' false. A budget of zero means
+ * no limit. The budget covers the one-step search too. Any places
+ * left in the results are filled with the other candidates in their
+ * one-step order, so there are always as many results as were asked
+ * for (given that many words). These keep their one-step entropy as
+ * their value, which can't be compared with the two-step scores, so
+ * they always come after all the scored candidates, whatever their
+ * values. As in with_tree_guess, the list never gets full enough to
+ * be sorted again, so it keeps that order.
+ *
+ * If there is a decision tree which covers the guesses so far, its
+ * guess comes first as for best. The results are not cached.
+ ***********************************************************************/
+
+cwordle::result_list_t cwordle::best_lookahead(size_t how_many, size_t width, int budget)
+{
+    bool complete;
+    return best_lookahead(how_many, width, budget, complete);
+}
+
+cwordle::result_list_t cwordle::best_lookahead(size_t how_many, size_t width, int budget, bool &complete)
+{
+    auto tree_guess = the_decision_tree ? the_decision_tree->find(results) : std::nullopt;
+    if (tree_guess && how_many==1) {
+        complete = true;
+        return tree_guess.value();
+    }
+    auto deadline = steady_clock::now() + milliseconds(budget);
+    result_list_t first = best_search(std::max(width, how_many), budget, complete);
+    vector<best_result_t> candidates(first.begin(), first.end());
+    const word_list &wl = current_list();
+    const auto &words = my_dict.get_words();
+    const U32 code_count = wordle_word::match_result::code_count();
+    const float total = wl.size();
+    result_list_t result(how_many);
+    mutex result_mutex;
+    std::atomic<bool> timed_out(false);
+    auto expired = [&]() {
+        if (budget > 0 && !timed_out && steady_clock::now() > deadline) {
+            timed_out = true;
+        }
+        return bool(timed_out);
+    };
+    auto score = [&](const best_result_t &c) -> optional<float> {
+        auto guess = my_dict.index_of(*c.key);
+        if (!guess) {
+            return std::nullopt;
+        }
+        auto groups = wl.partition(guess.value());
+        groups.erase(code_count - 1);
+        vector<pair<U32, word_list::word_vector_t*>> todo;
+        float optimistic = 0;
+        for (auto &g : groups) {
+            if (g.second.size() > 1) {
+                todo.emplace_back(g.first, &g.second);
+                optimistic += g.second.size() / total * std::log(float(std::min<size_t>(g.second.size(), code_count)));
+            }
+        }
+        std::sort(todo.begin(), todo.end(),
+                  [](const auto &a, const auto &b){ return a.second->size() > b.second->size(); });
+        float result_score = c.value;
+        for (const auto &t : todo) {
+            {
+                std::lock_guard<mutex> lock(result_mutex);
+                if (result_score + optimistic <= result.get_bound()) {
+                    return std::nullopt;
+                }
+            }
+            float p = t.second->size() / total;
+            float cap = std::log(float(std::min<size_t>(t.second->size(), code_count)));
+            optional<wordle_word::match_target> mt;
+            if (strict_mode) {
+                mt.emplace(*c.key, wordle_word::match_result::from_code(t.first));
+            }
+            word_list answers(my_dict, std::move(*t.second));
+            float follow = 0;
+            for (size_t i : irange(0ul, words.size())) {
+                if (i % best_chunk_size==0 && expired()) {
+                    return std::nullopt;
+                }
+                if (!mt || mt->conforms_exact(words[i].str())) {
+                    follow = std::max(follow, answers.entropy(words[i]));
+                    if (follow >= cap * 0.9999f) {
+                        break;
+                    }
+                }
+            }
+            result_score += p * follow;
+            optimistic -= p * cap;
+        }
+        return result_score;
+    };
+    parallel::for_chunks(candidates.size(), parallel::thread_count(candidates.size()), 1,
+                         [&](size_t, size_t b, size_t e) {
+                             for (size_t i : irange(b, e)) {
+                                 if (auto s = score(candidates[i])) {
+                                     std::lock_guard<mutex> lock(result_mutex);
+                                     result.insert(candidates[i].key, s.value());
+                                 }
+                             }
+                         });
+    complete = complete && !timed_out;
+    result_list_t filled(how_many);
+    filled.merge(result);       // the scored candidates, sorted by score
+    for (const auto &c : candidates) {
+        if (filled.size() >= how_many) {
+            break;
+        }
+        if (std::none_of(filled.begin(), filled.end(), [&](const auto &r){ return r.key==c.key; })) {
+            filled.insert(c.key, c.value);
+        }
+    }
+    return tree_guess ? with_tree_guess(tree_guess.value(), filled, how_many) : filled;
+}
+
+/************************************************************************
+ * best_cache_key - return the key for the current state in the
+ * best_cache, if it is one that the cache holds, i.e. there have been
+ * no guesses, or one guess of one of the top openers
+ ***********************************************************************/
+
+optional<U64> cwordle::best_cache_key() const
+{
+    optional<U64> result;
+    if (results.empty()) {
+        result = best_cache::empty_key;
+    } else if (results.size()==1) {
+        if (auto guess = my_dict.find(results[0].str())) {
+            result = best_cache::make_key(guess.value(), results[0].get_result().get_code());
+        }
+    }
+    if (result && !the_best_cache->covers(result.value())) {
+        result.reset();
+    }
+    return result;
+}
+
+/************************************************************************
+ * best_lru_key - return the key for the current state in the best_lru.
+ * This is the hash of the word list, plus in strict mode the last
+ * guess and its result, which determine the words that best() will
+ * consider. The dictionary size is included, since adding words
+ * changes the candidates without changing the list.
+ ***********************************************************************/
+
+U64 cwordle::best_lru_key(const word_list &wl) const
+{
+    U64 result = wl.hash();
+    size_t dict_size = my_dict.size();
+    result = fnv_hash(&dict_size, sizeof(dict_size), result);
+    if (strict_mode && !empty()) {
+        string_view guess = get_last_result().str();
+        U32 code = get_last_result().get_result().get_code();
+        result = fnv_hash(guess.data(), guess.size(), result);
+        result = fnv_hash(&code, sizeof(code), result);
+    }
+    return result;
+}
+
 /************************************************************************
  * entropy - return the entropy of the given word with respect
  * to the remaining valid words.
@@ -67,13 +421,7 @@ cwordle::result_list_t cwordle::best(size_t how_many)
 
 float cwordle::entropy(const wordle_word &w)
 {
-    float result = 0;
-    if (word_lists.empty()) {
-        result = all_my_words.entropy(w);
-    } else {
-        result = word_lists.back().entropy(w);
-    }
-    return result;
+    return current_list().entropy(w);
 }
 
 /************************************************************************
@@ -86,13 +434,13 @@ void cwordle::new_word()
 }
 
 /************************************************************************
- * remaining - list remaining usable words
+ * remaining - list remaining usable words, i.e. those which are
+ * also in the dictionary's allowed set
  ***********************************************************************/
 
 const word_list cwordle::remaining() const
 {
-    return (word_lists.empty() ? all_my_words : word_lists.back())
-        .filter_pred([&](const string_view &w){ return my_dict.is_allowed(w); });
+    return current_list().intersect(my_dict.get_allowed_bits());
 }
 
 /************************************************************************
@@ -111,7 +459,22 @@ const wordle_word &cwordle::get_current_word() const
 void cwordle::clear()
 {
     results.clear();
-    word_lists.clear();
+    history.clear();
+    current.reset();
+    tracker.reset();
+}
+
+/************************************************************************
+ * reset - make the game as good as new, so that it can be reused for
+ * another game. The vectors keep their capacity, but the entropy
+ * tracker, if any, is freed by clear(): it is large, and would have
+ * to be rebuilt for the new game anyway.
+ ***********************************************************************/
+
+void cwordle::reset()
+{
+    clear();
+    abandoned = false;
 }
 
 /************************************************************************
@@ -132,16 +495,19 @@ bool cwordle::set_word(const string_view &w)
 }
 
 /************************************************************************
- * set_result - add a word and its result to the current result list
+ * set_result - add a word and its result to the current result list.
+ * If the word is in the dictionary and we have a pattern_matrix,
+ * filtering is done by table lookup.
  ***********************************************************************/
 
 void cwordle::set_result(const wordle_word &w, const wordle_word::match_result &mr)
 {
     results.emplace_back(w, mr);
-    wordle_word::match_target mt(w, mr);
-    word_list base_wl(my_dict);
-    const word_list &wl = word_lists.empty() ? base_wl : word_lists.back();
-    word_lists.emplace_back(wl.filter(mt));
+    const word_list &wl = current_list();
+    auto guess = my_dict.get_matrix().valid() ? my_dict.find(w.str()) : std::nullopt;
+    word_list filtered = guess ? wl.filter(guess.value(), mr) : wl.filter(wordle_word::match_target(w, mr));
+    history.push(filtered.begin(), filtered.end());
+    current.emplace(std::move(filtered));
 }
 
 /************************************************************************
@@ -157,14 +523,23 @@ wordle_word::match_result cwordle::try_word(const wordle_word &w)
 }
 
 /************************************************************************
- * undo - remove the last attempt
+ * undo - remove the last attempt. The current list is made again from
+ * the top of the history, in index order as the filters leave it.
  ***********************************************************************/
     
 void cwordle::undo()
 {
     if (size() > 0) {
         results.pop_back();
-        word_lists.pop_back();
+        history.pop();
+        if (history.empty()) {
+            current.reset();
+        } else {
+            word_list::word_vector_t words;
+            words.reserve(history.count());
+            history.for_each([&](word_bitset_stack::index_t i){ words.emplace_back(i); });
+            current.emplace(my_dict, std::move(words));
+        }
     }
 }
 
@@ -6,6 +6,7 @@
 #include "wordle_word.h"
 #include "partial_sorted_list.h"
 #include "word_list.h"
+#include "entropy_tracker.h"
 
 class cwordle
 {
@@ -16,12 +17,17 @@ private:
     dictionary &my_dict;
     word_list all_my_words;
     vector<wordle_word::match_target> results;
-    vector<word_list> word_lists;
+    word_bitset_stack history;
+    optional<word_list> current;
     wordle_word current_word;
     bool abandoned = false;
+    unique_ptr<entropy_tracker> tracker;
 public:
     cwordle(dictionary *dict)
-        : my_dict(*dict), all_my_words(my_dict) { };
+        : my_dict(*dict), all_my_words(my_dict), history(my_dict.size(), max_guesses)
+    {
+        results.reserve(max_guesses);
+    };
     void load_words(const vector<string> &w);
     void load_words(const string_view &s);
     bool load_file(const string &filename);
@@ -44,6 +50,11 @@ public:
         return results.back();
     }
     cwordle::result_list_t best(size_t how_many);
+    cwordle::result_list_t best(size_t how_many, int budget, bool &complete);
+    cwordle::result_list_t best_lookahead(size_t how_many, size_t width, int budget);
+    cwordle::result_list_t best_lookahead(size_t how_many, size_t width, int budget, bool &complete);
+    optional<U64> best_cache_key() const;
+    U64 best_lru_key(const word_list &wl) const;
     float entropy(const wordle_word &w);
     void new_word();
     const vector<wordle_word::match_target> &get_results()
@@ -56,6 +67,7 @@ public:
     wordle_word::match_result try_word(const wordle_word &w);
     void undo();
     void clear();
+    void reset();
     bool add_word(const string &w);
     bool test_exact(const string_view &w);
     bool is_won() const
@@ -91,6 +103,15 @@ public:
         return result;
     }
     const wordle_word &get_current_word() const;
+private:
+    const word_list &current_list() const
+    {
+        return current ? current.value() : all_my_words;
+    }
+    cwordle::result_list_t best_search(size_t how_many, int budget, bool &complete);
+    cwordle::result_list_t with_tree_guess(const result_list_t &tree_guess, const result_list_t &found,
+                                           size_t how_many) const;
+    vector<dictionary::word_index_t> candidate_order(const word_list &wl) const;
 };
 
 #endif
@@ -0,0 +1,315 @@
+#include "decision_tree.h"
+#include "parallel.h"
+#include <fstream>
+#include <cstring>
+
+static const char tree_magic[8] = "CWTREE";
+static const U32 tree_version = 1;
+
+/************************************************************************
+ * A guess which might itself be the answer is worth a little more
+ * than one which can't, since it may finish the game. This just breaks
+ * ties between candidates with (almost) the same entropy.
+ ***********************************************************************/
+
+const float answer_bonus = 0.001;
+
+/************************************************************************
+ * Constructor - the config covers the dictionary contents and the
+ * mode, as for best_cache
+ ***********************************************************************/
+
+decision_tree::decision_tree(const dictionary &dict)
+    : my_dict(dict), strict(strict_mode), dict_size(dict.size()), allowed_size(dict.allowed_size())
+{
+    config = fnv_hash(&strict, sizeof(strict), dict.fingerprint());
+}
+
+/************************************************************************
+ * build - build the tree for the whole dictionary.
+ *
+ * At each node the candidate guesses are ranked by their entropy
+ * against the answers still possible there, plus answer_bonus for
+ * those which could themselves be the answer. With a width of 1 the
+ * best of them is used. This is not the same choice as best makes,
+ * which scores against every word that fits rather than just the
+ * allowed answers, and has no bonus: for instance the English tree
+ * opens with "soare" where best gives "tares". With a greater width
+ * the subtree of each of the top 'width' candidates is built, and the
+ * one which takes fewest guesses in total over its answers is kept.
+ * This gives a better tree, but the time taken goes up by about a
+ * factor of 'width' for each level, so 2 or 3 is as much as is
+ * practical.
+ *
+ * The work at the root, both scoring candidates and building the
+ * subtree for each result, is shared between threads. Below that each
+ * subtree is built by a single thread.
+ ***********************************************************************/
+
+void decision_tree::build(size_t w)
+{
+    width = std::max(w, 1ul);
+    nodes.clear();
+    branches.clear();
+    my_stats = stats();
+    word_list answers = my_dict.allowed_size() > 0
+        ? word_list(my_dict, my_dict.get_allowed_bits())
+        : word_list(my_dict);
+    word_list candidates(my_dict);
+    answers.begin();            // fill them now, rather than racing to do so in the threads
+    candidates.begin();
+    if (answers.empty()) {
+        return;
+    }
+    auto root = build_subtree(answers, candidates, true);
+    flatten(*root);
+    my_stats.nodes = nodes.size();
+    my_stats.answers = answers.size();
+    my_stats.total_guesses = root->cost;
+    my_stats.max_guesses = root->depth;
+}
+
+/************************************************************************
+ * build_subtree - build the subtree which finds each of the given
+ * answers, choosing the guess from the candidates as described above.
+ * With one or two answers left, the first of them is the guess.
+ ***********************************************************************/
+
+unique_ptr<decision_tree::build_node> decision_tree::build_subtree(const word_list &answers,
+                                                                   const word_list &candidates,
+                                                                   bool parallel) const
+{
+    if (answers.size() <= 2) {
+        return build_guess(answers, candidates, answers[0], answers.entropy(my_dict[answers[0]]), parallel);
+    }
+    word_bitset answer_bits = answers.bits();
+    auto score = [&](word_index_t g) {
+        return answers.entropy(my_dict[g]) + (answer_bits.test(g) ? answer_bonus : 0);
+    };
+    partial_sorted_list<word_index_t, float> ranked(width);
+    if (parallel) {
+        size_t threads = parallel::thread_count(candidates.size() / 64);
+        vector<partial_sorted_list<word_index_t, float>> partials(threads, ranked);
+        parallel::for_chunks(candidates.size(), threads, 64,
+                             [&](size_t worker, size_t b, size_t e) {
+                                 for (size_t i : irange(b, e)) {
+                                     partials[worker].insert(candidates[i], score(candidates[i]));
+                                 }
+                             });
+        for (const auto &p : partials) {
+            ranked.merge(p);
+        }
+    } else {
+        for (word_index_t g : candidates) {
+            ranked.insert(g, score(g));
+        }
+    }
+    unique_ptr<build_node> result;
+    for (const auto &r : ranked) {
+        float entropy = r.value - (answer_bits.test(r.key) ? answer_bonus : 0);
+        auto bn = build_guess(answers, candidates, r.key, entropy, parallel);
+        if (bn && (!result || bn->cost < result->cost
+                   || (bn->cost==result->cost && bn->depth < result->depth))) {
+            result = std::move(bn);
+        }
+    }
+    if (!result) {
+        result = build_guess(answers, candidates, answers[0], 0, parallel);
+    }
+    return result;
+}
+
+/************************************************************************
+ * build_guess - build the subtree for the given guess: split the
+ * answers by the result the guess gives for each of them, and build
+ * the subtree for each result other than the one which solves the
+ * game. Return nothing if the guess doesn't split the answers at
+ * all, since it would get us nowhere.
+ ***********************************************************************/
+
+unique_ptr<decision_tree::build_node> decision_tree::build_guess(const word_list &answers,
+                                                                 const word_list &candidates,
+                                                                 word_index_t guess, float entropy,
+                                                                 bool parallel) const
+{
+    auto groups = answers.partition(guess);
+    groups.erase(wordle_word::match_result::code_count() - 1);
+    if (groups.size()==1 && groups.begin()->second.size()==answers.size()) {
+        return nullptr;
+    }
+    auto result = std::make_unique<build_node>();
+    result->guess = guess;
+    result->entropy = entropy;
+    vector<pair<U32, word_list::word_vector_t>> todo(std::make_move_iterator(groups.begin()),
+                                                     std::make_move_iterator(groups.end()));
+    result->children.resize(todo.size());
+    auto build_child = [&](size_t i) {
+        U32 code = todo[i].first;
+        word_list child_answers(my_dict, std::move(todo[i].second));
+        result->children[i].first = code;
+        if (strict) {
+            wordle_word::match_target mt(my_dict[guess], wordle_word::match_result::from_code(code));
+            result->children[i].second = build_subtree(child_answers, word_list(my_dict).filter_exact(mt), false);
+        } else {
+            result->children[i].second = build_subtree(child_answers, candidates, false);
+        }
+    };
+    if (parallel) {
+        parallel::for_chunks(todo.size(), parallel::thread_count(todo.size()), 1,
+                             [&](size_t, size_t b, size_t e) {
+                                 for (size_t i : irange(b, e)) {
+                                     build_child(i);
+                                 }
+                             });
+    } else {
+        for (size_t i : irange(0ul, todo.size())) {
+            build_child(i);
+        }
+    }
+    result->cost = answers.size();
+    result->depth = 1;
+    for (const auto &c : result->children) {
+        result->cost += c.second->cost;
+        result->depth = std::max(result->depth, c.second->depth + 1);
+    }
+    return result;
+}
+
+/************************************************************************
+ * flatten - append a built subtree to the node and branch arrays,
+ * returning the index of its root. The branches for a node are
+ * reserved before its children are added, so they stay contiguous.
+ ***********************************************************************/
+
+U32 decision_tree::flatten(const build_node &bn)
+{
+    U32 result = nodes.size();
+    U32 first = branches.size();
+    nodes.push_back(node{ bn.guess, bn.entropy, first, U32(bn.children.size()) });
+    branches.resize(first + bn.children.size());
+    for (size_t i : irange(0ul, bn.children.size())) {
+        U32 child = flatten(*bn.children[i].second);
+        branches[first + i] = branch{ bn.children[i].first, child };
+    }
+    return result;
+}
+
+/************************************************************************
+ * find - follow the guesses and results so far down the tree, and
+ * return the guess at the node they lead to. Return nothing if the
+ * tree doesn't apply, or if a guess isn't the one the tree made.
+ *
+ * Each node holds just the one guess, so that is all there is: if more
+ * words are asked for, best fills in the rest.
+ ***********************************************************************/
+
+optional<cwordle::result_list_t> decision_tree::find(const vector<wordle_word::match_target> &results) const
+{
+    optional<cwordle::result_list_t> result;
+    if (!valid()) {
+        return result;
+    }
+    U32 n = 0;
+    for (const auto &mt : results) {
+        const node &nd = nodes[n];
+        if (mt.str() != my_dict.get_string(nd.guess)) {
+            return result;
+        }
+        U32 code = mt.get_result().get_code();
+        auto b = branches.begin() + nd.first_branch;
+        auto e = b + nd.branch_count;
+        auto iter = std::lower_bound(b, e, code,
+                                     [](const branch &br, U32 c){ return br.code < c; });
+        if (iter==e || iter->code != code) {
+            return result;
+        }
+        n = iter->child;
+    }
+    result = cwordle::result_list_t(1);
+    result->insert(&my_dict[nodes[n].guess], nodes[n].entropy);
+    return result;
+}
+
+/************************************************************************
+ * save - write the tree to a file. Return false if it can't be
+ * written.
+ ***********************************************************************/
+
+bool decision_tree::save(const string &filename) const
+{
+    file_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, tree_magic, sizeof(h.magic));
+    h.version = tree_version;
+    h.word_length = word_length;
+    h.config = config;
+    h.node_count = nodes.size();
+    h.branch_count = branches.size();
+    h.total_guesses = my_stats.total_guesses;
+    h.max_guesses = my_stats.max_guesses;
+    h.answer_count = my_stats.answers;
+    std::ofstream ostr(filename, std::ios::binary | std::ios::trunc);
+    ostr.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    ostr.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(node));
+    ostr.write(reinterpret_cast<const char*>(branches.data()), branches.size() * sizeof(branch));
+    return ostr.good();
+}
+
+/************************************************************************
+ * load - read a tree written by save. Return false, leaving the tree
+ * unchanged, if the file can't be read or is for a different
+ * dictionary or mode. The counts in the header must match the size of
+ * the file exactly, and every index in it is checked, so a damaged
+ * file can't lead us astray.
+ ***********************************************************************/
+
+bool decision_tree::load(const string &filename)
+{
+    std::ifstream istr(filename, std::ios::binary);
+    file_header h;
+    if (!istr.read(reinterpret_cast<char*>(&h), sizeof(h))
+        || memcmp(h.magic, tree_magic, sizeof(h.magic)) != 0
+        || h.version != tree_version
+        || h.config != config
+        || h.node_count==0 || h.node_count > my_dict.size() * my_dict.size()) {
+        return false;
+    }
+    istr.seekg(0, std::ios::end);
+    std::streamoff file_size = istr.tellg();
+    if (!istr || file_size < std::streamoff(sizeof(h))) {
+        return false;
+    }
+    U64 body_size = U64(file_size) - sizeof(h);
+    if (h.node_count > body_size / sizeof(node)) {
+        return false;
+    }
+    U64 branch_size = body_size - h.node_count * sizeof(node);
+    if (branch_size % sizeof(branch) != 0
+        || h.branch_count != branch_size / sizeof(branch)
+        || h.branch_count > h.node_count * wordle_word::match_result::code_count()) {
+        return false;
+    }
+    istr.seekg(sizeof(h));
+    vector<node> n(h.node_count);
+    vector<branch> b(h.branch_count);
+    if (!istr.read(reinterpret_cast<char*>(n.data()), n.size() * sizeof(node))
+        || !istr.read(reinterpret_cast<char*>(b.data()), b.size() * sizeof(branch))) {
+        return false;
+    }
+    bool ok = std::all_of(n.begin(), n.end(), [&](const node &nd) {
+        return nd.guess < my_dict.size() && U64(nd.first_branch) + nd.branch_count <= b.size();
+    });
+    ok = ok && std::all_of(b.begin(), b.end(), [&](const branch &br) {
+        return br.child < n.size();
+    });
+    if (!ok) {
+        return false;
+    }
+    nodes = std::move(n);
+    branches = std::move(b);
+    my_stats.nodes = nodes.size();
+    my_stats.answers = h.answer_count;
+    my_stats.total_guesses = h.total_guesses;
+    my_stats.max_guesses = h.max_guesses;
+    return true;
+}
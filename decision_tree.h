@@ -0,0 +1,115 @@
+#ifndef __DECISION_TREE
+#define __DECISION_TREE
+
+#include "types.h"
+#include "cwordle.h"
+
+/************************************************************************
+ * decision_tree - a complete precomputed strategy: the guess to make
+ * at the start, then for each result it can give the guess to make
+ * next, and so on until every possible answer has been found.
+ *
+ * The tree is built offline (see build) and saved to a file. Once it
+ * is loaded, cwordle::best answers by following the guesses and results
+ * so far down from the root, which takes one step per guess, rather
+ * than scoring every word in the dictionary. If more than one word is
+ * asked for, the rest come from the usual search. If a game has made
+ * a guess the tree didn't, find gives nothing and best works as usual.
+ *
+ * The answers are the dictionary's allowed words, or all the words if
+ * there is no allowed list. In strict mode the guess at each node must
+ * conform to the result that led to it, as for best.
+ *
+ * In memory and in the file the tree is a flat array of nodes, each
+ * with a contiguous run of branches sorted by match code, each branch
+ * giving the index of its child node. The result which solves the
+ * game has no branch. The file also carries the config (a hash of the
+ * dictionary fingerprint and strict mode), and a tree for some other
+ * config is refused. As with best_cache, if the dictionary changes
+ * after the tree is built or loaded, the tree is bypassed.
+ *
+ * Once built or loaded the tree doesn't change, so it can be shared
+ * between games without locking.
+ ***********************************************************************/
+
+class decision_tree
+{
+public:
+    typedef dictionary::word_index_t word_index_t;
+    struct stats
+    {
+        size_t nodes = 0;
+        size_t answers = 0;
+        U64 total_guesses = 0;
+        U32 max_guesses = 0;
+    };
+private:
+    struct node
+    {
+        word_index_t guess;
+        float entropy;
+        U32 first_branch;
+        U32 branch_count;
+    };
+    struct branch
+    {
+        U32 code;
+        U32 child;
+    };
+    struct file_header
+    {
+        char magic[8];
+        U32 version;
+        U32 word_length;
+        U64 config;
+        U64 node_count;
+        U64 branch_count;
+        U64 total_guesses;
+        U32 max_guesses;
+        U32 answer_count;
+    };
+    struct build_node
+    {
+        word_index_t guess = 0;
+        float entropy = 0;
+        U64 cost = 0;                   // total guesses for all answers below here
+        U32 depth = 0;                  // most guesses for any answer below here
+        vector<pair<U32, unique_ptr<build_node>>> children;
+    };
+    const dictionary &my_dict;
+    U64 config;
+    bool strict;
+    size_t dict_size;
+    size_t allowed_size;
+    size_t width = 1;
+    vector<node> nodes;                 // the root is nodes[0]
+    vector<branch> branches;
+    stats my_stats;
+public:
+    decision_tree(const dictionary &dict);
+    void build(size_t w=1);
+    bool load(const string &filename);
+    bool save(const string &filename) const;
+    optional<cwordle::result_list_t> find(const vector<wordle_word::match_target> &results) const;
+    const stats &get_stats() const
+    {
+        return my_stats;
+    }
+    size_t size() const
+    {
+        return nodes.size();
+    }
+private:
+    bool valid() const
+    {
+        return !nodes.empty() && my_dict.size()==dict_size
+            && my_dict.allowed_size()==allowed_size && strict==strict_mode;
+    }
+    unique_ptr<build_node> build_subtree(const word_list &answers, const word_list &candidates,
+                                         bool parallel) const;
+    unique_ptr<build_node> build_guess(const word_list &answers, const word_list &candidates,
+                                       word_index_t guess, float entropy, bool parallel) const;
+    U32 flatten(const build_node &bn);
+};
+
+#endif
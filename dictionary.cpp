@@ -1,6 +1,65 @@
 #include "dictionary.h"
 #include "random.h"
+#include "entropy.h"
 #include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/************************************************************************
+ * Binary dictionary image.
+ *
+ * The image holds the dictionary in its in-memory layout, so that
+ * load_image can mmap it and use it in place, with no parsing and no
+ * wordle_word::set_word calls. The words, the allowed list and the
+ * arrays behind the index, the match_view and (if it was built when
+ * the image was written) the pattern matrix are all used directly from
+ * the mapped pages, which are shared between processes using the same
+ * image. Only the allowed bitset is rebuilt. Anything which changes
+ * the dictionary afterwards copies the part it changes.
+ *
+ * The file is an image_header followed by the sections listed in
+ * image_section_e, each starting on a 64 byte boundary. An image is
+ * only good for the build which wrote it, so the header records
+ * sizeof(wordle_word) and MAX_WORD_LENGTH as well as a version, and
+ * an image which doesn't agree is refused.
+ ***********************************************************************/
+
+static const char image_magic[8] = "CWDICT";
+static const U32 image_version = 1;
+static const size_t image_align = 64;
+
+enum image_section_e
+{
+    sect_words,
+    sect_allowed,
+    sect_keys,
+    sect_values,
+    sect_all_letters,
+    sect_repeated_letters,
+    sect_matrix,
+    sect_positions,
+    sect_count = sect_positions + MAX_WORD_LENGTH,
+};
+
+struct image_header
+{
+    char magic[8];
+    U32 version;
+    U32 word_size;
+    U32 word_length;
+    U32 max_word_length;
+    U64 word_count;
+    U64 allowed_count;
+    U64 index_capacity;
+    U64 matrix_size;
+    U64 offsets[sect_count];
+    U64 lengths[sect_count];
+};
+
+static_assert(std::is_trivially_copyable_v<wordle_word>);
 
 /************************************************************************
  * init - create the single staic dictionary
@@ -13,6 +72,17 @@ void dictionary::init()
     the_dictionary->load_allowed(::allowed_words);
 }
 
+/************************************************************************
+ * Destructor - release the image, if we have one
+ ***********************************************************************/
+
+dictionary::~dictionary()
+{
+    if (image) {
+        munmap(image, image_size);
+    }
+}
+
 /************************************************************************
  * load_file - load words from a file. Return false if there was
  * a problem.
@@ -31,6 +101,7 @@ bool dictionary::load_file_base(const string &filename, std::function<bool(const
                 inserter(line);
             }
         }
+        entropy_table_init(size());
     }
     return result;
 }
@@ -78,10 +149,10 @@ bool dictionary::insert(const string_view &w, int method)
     bool result = false;
     string groomed = wordle_word::groom(w);
     if (!groomed.empty()) {
-        if (word_map.find(groomed) == word_map.end()) {
-            size_t i = words.size();
+        if (index.insert(groomed, words.size())) {
+            matrix.clear();
             words.emplace_back(groomed, method);
-            word_map[groomed] = i;
+            view.append(words.back());
             result = true;
         }
     }
@@ -98,29 +169,38 @@ bool dictionary::insert_allowed(const string_view &w)
     if (!i) {
         insert(w);
         i = find(w);
+        if (!i) {
+            return false;
+        }
     }
     allowed_words.push_back(i.value());
-    allowed_word_set.insert(i.value());
+    allowed_bits.set(i.value());
     return true;
 }
 
 /************************************************************************
- * load and load_allowed - pre-allocate the vectors before loading
+ * load and load_allowed - pre-allocate the vectors before loading, and
+ * make sure the entropy table is big enough afterwards
  ***********************************************************************/
 
 void dictionary::load(const string_view &s)
 {
-    words.reserve(words.size() + count_words(s));
+    size_t wc = count_words(s);
+    words.reserve(words.size() + wc);
+    index.reserve(words.size() + wc);
     load_base(s, [&](const string_view &w){ return insert(w, 0); });
+    entropy_table_init(size());
 }
 
 void dictionary::load_allowed(const string_view &s)
 {
     size_t wc = count_words(s);
     words.reserve(words.size() + wc);
+    index.reserve(words.size() + wc);
     allowed_words.reserve(allowed_words.size() + wc);
     load_base(s,
               [&](const string_view &w){ return insert_allowed(w); });
+    entropy_table_init(size());
 }
 
 /************************************************************************
@@ -130,12 +210,7 @@ void dictionary::load_allowed(const string_view &s)
 
 optional<dictionary::word_index_t> dictionary::find(const string_view &w) const
 {
-    optional<word_index_t> result;
-    auto iter = word_map.find(string(w));
-    if (iter != word_map.end()) {
-        result = iter->second;
-    }
-    return result;
+    return index.find(w);
 }
 
 /************************************************************************
@@ -173,5 +248,185 @@ string_view dictionary::get_allowed() const
 bool dictionary::is_allowed(const string_view &w) const
 {
     auto i = find(w);
-    return i && (allowed_word_set.find(i.value()) != allowed_word_set.end());
+    return i && allowed_bits.test(i.value());
+}
+
+/************************************************************************
+ * fingerprint - a hash of the words and the allowed set, used to tell
+ * whether saved results still apply to this dictionary
+ ***********************************************************************/
+
+U64 dictionary::fingerprint() const
+{
+    U64 result = fnv_hash(&word_length, sizeof(word_length));
+    for (const wordle_word &w : words) {
+        result = fnv_hash(w.str().data(), w.size(), result);
+    }
+    return fnv_hash(allowed_words.data(), allowed_words.size() * sizeof(word_index_t), result);
+}
+
+/************************************************************************
+ * write_image - write the dictionary as a binary image (see above).
+ * Return false if the file can't be written.
+ ***********************************************************************/
+
+bool dictionary::write_image(const string &filename) const
+{
+    image_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, image_magic, sizeof(h.magic));
+    h.version = image_version;
+    h.word_size = sizeof(wordle_word);
+    h.word_length = word_length;
+    h.max_word_length = MAX_WORD_LENGTH;
+    h.word_count = size();
+    h.allowed_count = allowed_words.size();
+    h.index_capacity = index.capacity();
+    h.matrix_size = matrix.size();
+    array<const void*, sect_count> data = {};
+    auto set_section = [&](int s, const void *d, size_t length) {
+        data[s] = d;
+        h.lengths[s] = length;
+    };
+    set_section(sect_words, words.data(), size() * sizeof(wordle_word));
+    set_section(sect_allowed, allowed_words.data(), allowed_words.size() * sizeof(word_index_t));
+    set_section(sect_keys, index.get_keys(), index.capacity() * sizeof(word_index::key_t));
+    set_section(sect_values, index.get_values(), index.capacity() * sizeof(word_index::value_t));
+    set_section(sect_all_letters, view.get_all_letters(), size() * sizeof(U32));
+    set_section(sect_repeated_letters, view.get_repeated_letters(), size() * sizeof(U32));
+    set_section(sect_matrix, matrix.data(), matrix.size() * matrix.size() * sizeof(pattern_matrix::code_t));
+    for (int i : irange(0, word_length)) {
+        set_section(sect_positions + i, view.get_position_letters(i), size() * sizeof(U32));
+    }
+    auto align = [](U64 offset) { return (offset + image_align - 1) & ~(image_align - 1); };
+    U64 offset = align(sizeof(h));
+    for (int s : irange(0, int(sect_count))) {
+        h.offsets[s] = offset;
+        offset = align(offset + h.lengths[s]);
+    }
+    std::ofstream ostr(filename, std::ios::binary | std::ios::trunc);
+    ostr.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    U64 written = sizeof(h);
+    const char padding[image_align] = {};
+    for (int s : irange(0, int(sect_count))) {
+        ostr.write(padding, h.offsets[s] - written);
+        if (h.lengths[s] > 0) {
+            ostr.write(static_cast<const char*>(data[s]), h.lengths[s]);
+        }
+        written = h.offsets[s] + h.lengths[s];
+    }
+    return ostr.good();
+}
+
+/************************************************************************
+ * load_image - replace the contents of the dictionary with a binary
+ * image written by write_image. The global word_length is set from the
+ * image. Return false, leaving the dictionary unchanged, if the file
+ * can't be read or wasn't written by a compatible build.
+ *
+ * Nothing in the file is trusted: every section must have the length
+ * implied by the counts in the header (worked out so that a huge count
+ * can't wrap round to a small length) and lie within the file, and
+ * every word index in the allowed list and the hash index must be in
+ * range, so that a truncated or corrupt image can't make us read
+ * outside the mapping or write outside the allowed set.
+ ***********************************************************************/
+
+bool dictionary::load_image(const string &filename)
+{
+    void *base = MAP_FAILED;
+    size_t file_size = 0;
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st)==0 && size_t(st.st_size) >= sizeof(image_header)) {
+            file_size = st.st_size;
+            base = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+    }
+    if (base==MAP_FAILED) {
+        return false;
+    }
+    const image_header &h = *static_cast<const image_header*>(base);
+    auto fits = [&](U64 count, size_t size) { return count <= file_size / size; };
+    bool ok = memcmp(h.magic, image_magic, sizeof(h.magic))==0
+        && h.version==image_version
+        && h.word_size==sizeof(wordle_word)
+        && h.max_word_length==MAX_WORD_LENGTH
+        && h.word_length > 0 && h.word_length <= MAX_WORD_LENGTH
+        && fits(h.word_count, sizeof(wordle_word))
+        && h.word_count < std::numeric_limits<word_index_t>::max()
+        && fits(h.allowed_count, sizeof(word_index_t))
+        && fits(h.index_capacity, sizeof(word_index::key_t))
+        && h.index_capacity > 0 && (h.index_capacity & (h.index_capacity - 1))==0
+        && h.index_capacity >= 2 * h.word_count
+        && (h.matrix_size==0 || h.matrix_size==h.word_count)
+        && (h.matrix_size==0 || fits(h.matrix_size, h.matrix_size * sizeof(pattern_matrix::code_t)))
+        && h.lengths[sect_words]==h.word_count * sizeof(wordle_word)
+        && h.lengths[sect_allowed]==h.allowed_count * sizeof(word_index_t)
+        && h.lengths[sect_keys]==h.index_capacity * sizeof(word_index::key_t)
+        && h.lengths[sect_values]==h.index_capacity * sizeof(word_index::value_t)
+        && h.lengths[sect_all_letters]==h.word_count * sizeof(U32)
+        && h.lengths[sect_repeated_letters]==h.word_count * sizeof(U32)
+        && h.lengths[sect_matrix]==h.matrix_size * h.matrix_size * sizeof(pattern_matrix::code_t);
+    for (int i : irange(0u, ok ? h.word_length : 0u)) {
+        ok = ok && h.lengths[sect_positions + i]==h.word_count * sizeof(U32);
+    }
+    for (int s : irange(0, int(sect_count))) {
+        ok = ok && h.offsets[s] % image_align==0
+            && h.offsets[s] <= file_size && h.lengths[s] <= file_size - h.offsets[s];
+    }
+    auto section = [&](int s) { return static_cast<const char*>(base) + h.offsets[s]; };
+    if (ok) {
+        auto allowed = reinterpret_cast<const word_index_t*>(section(sect_allowed));
+        ok = std::all_of(allowed, allowed + h.allowed_count,
+                         [&](word_index_t i) { return i < h.word_count; });
+    }
+    if (ok) {
+        auto keys = reinterpret_cast<const word_index::key_t*>(section(sect_keys));
+        auto values = reinterpret_cast<const word_index::value_t*>(section(sect_values));
+        U64 used = 0;
+        for (size_t i : irange(0ul, size_t(h.index_capacity))) {
+            if (keys[i] != 0) {
+                ++used;
+                ok = ok && values[i] < h.word_count;
+            }
+        }
+        ok = ok && used==h.word_count;
+    }
+    if (!ok) {
+        munmap(base, file_size);
+        return false;
+    }
+    if (image) {
+        munmap(image, image_size);
+    }
+    image = base;
+    image_size = file_size;
+    word_length = h.word_length;
+    words.map(reinterpret_cast<const wordle_word*>(section(sect_words)), h.word_count);
+    allowed_words.map(reinterpret_cast<const word_index_t*>(section(sect_allowed)), h.allowed_count);
+    allowed_bits = word_bitset(h.word_count);
+    for (word_index_t i : allowed_words) {
+        allowed_bits.set(i);
+    }
+    index.map(reinterpret_cast<const word_index::key_t*>(section(sect_keys)),
+              reinterpret_cast<const word_index::value_t*>(section(sect_values)),
+              h.index_capacity, h.word_count);
+    array<const U32*, MAX_WORD_LENGTH> positions = {};
+    for (int i : irange(0, word_length)) {
+        positions[i] = reinterpret_cast<const U32*>(section(sect_positions + i));
+    }
+    view.map(positions,
+             reinterpret_cast<const U32*>(section(sect_all_letters)),
+             reinterpret_cast<const U32*>(section(sect_repeated_letters)),
+             h.word_count);
+    if (h.matrix_size > 0) {
+        matrix.map(reinterpret_cast<const pattern_matrix::code_t*>(section(sect_matrix)), h.matrix_size);
+    } else {
+        matrix.clear();
+    }
+    entropy_table_init(size());
+    return true;
 }
@@ -3,23 +3,32 @@
 
 #include "types.h"
 #include "wordle_word.h"
+#include "pattern_matrix.h"
+#include "match_view.h"
+#include "word_bitset.h"
+#include "word_index.h"
+#include "mapped_array.h"
 
 class dictionary
 {
 public:
-    typedef vector<wordle_word> words_t;
-    typedef words_t::iterator iterator;
+    typedef mapped_array<wordle_word> words_t;
     typedef words_t::const_iterator const_iterator;
     typedef U32 word_index_t;
-    typedef map<string, word_index_t> word_map_t;
-    typedef vector<word_index_t> word_list_t;
-    typedef std::set<word_index_t> word_set_t;
+    typedef mapped_array<word_index_t> word_list_t;
 private:
     words_t words;
-    word_map_t word_map;
+    word_index index;
     word_list_t allowed_words;
-    word_set_t allowed_word_set;
+    word_bitset allowed_bits;
+    pattern_matrix matrix;
+    match_view view;
+    void *image = nullptr;
+    size_t image_size = 0;
 public:
+    dictionary() { };
+    dictionary(const dictionary&) = delete;
+    ~dictionary();
     size_t size() const
     {
         return words.size();
@@ -43,9 +52,25 @@ public:
         return words[idx].str();
     }
     optional<word_index_t> find(const string_view &w) const;
+    /************************************************************************
+     * index_of - if the word is one of ours (not just a copy of one),
+     * return its index
+     ***********************************************************************/
+    optional<word_index_t> index_of(const wordle_word &w) const
+    {
+        optional<word_index_t> result;
+        if (!words.empty() && &w >= &words.front() && &w <= &words.back()) {
+            result = &w - &words.front();
+        }
+        return result;
+    }
     optional<const wordle_word*> find_word(const string_view &w) const;
     string_view get_allowed() const;
     bool is_allowed(const string_view &w) const;
+    const word_bitset &get_allowed_bits() const
+    {
+        return allowed_bits;
+    }
     void load(const string_view &s);
     bool load_file(const string &filename)
     {
@@ -66,6 +91,21 @@ public:
     {
         return words.end();
     }
+    bool build_matrix()
+    {
+        return matrix.build(*this);
+    }
+    const pattern_matrix &get_matrix() const
+    {
+        return matrix;
+    }
+    const match_view &get_view() const
+    {
+        return view;
+    }
+    U64 fingerprint() const;
+    bool write_image(const string &filename) const;
+    bool load_image(const string &filename);
     static void init();
 private:
     void load_base(const string_view &s, std::function<bool(const string_view&)> inserter);
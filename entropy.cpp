@@ -69,6 +69,53 @@ float entropy(const vector<float> &data)
 #endif
 }
 
+/************************************************************************
+ * entropy - integer count version. The counts are always small integers
+ * (no more than the size of a word_list), and zero counts have already
+ * been removed by the histogram, so instead of taking logs we look up
+ * c*log(c) in a table built by entropy_table_init. Using the same
+ * trick as above:
+ *
+ * entropy = (sum * log(sum) - sum(c * log(c))) / sum
+ *
+ * Counts beyond the end of the table (e.g. if words have been added
+ * since) are calculated directly.
+ ***********************************************************************/
+
+static vector<float> nlogn_table;
+
+void entropy_table_init(size_t max_count)
+{
+    size_t old_size = nlogn_table.size();
+    if (max_count >= old_size) {
+        nlogn_table.resize(max_count + 1);
+        for (size_t c : irange(old_size, max_count + 1)) {
+            nlogn_table[c] = c==0 ? 0 : c * log(double(c));
+        }
+    }
+}
+
+inline double nlogn(U32 c)
+{
+    return likely(c < nlogn_table.size()) ? nlogn_table[c] : c * log(double(c));
+}
+
+float entropy(const U32 *counts, size_t n)
+{
+    double e = 0;
+    U32 sum = 0;
+    for (size_t i : irange(0ul, n)) {
+        e += nlogn(counts[i]);
+        sum += counts[i];
+    }
+    return sum ? (nlogn(sum) - e) / sum : 0.0;
+}
+
+float entropy(const vector<U32> &counts)
+{
+    return entropy(counts.data(), counts.size());
+}
+
 /************************************************************************
  * Non-AVX implementation but including the mathematical trick of
  * working with the raw values then normalising them to probabilities
@@ -6,5 +6,8 @@
 extern float entropy(const vector<float> &data);
 extern float entropy_slow(const vector<float> &data);
 extern float entropy_slowest(const vector<float> &data);
+extern float entropy(const U32 *counts, size_t n);
+extern float entropy(const vector<U32> &counts);
+extern void entropy_table_init(size_t max_count);
 
 #endif
@@ -0,0 +1,91 @@
+#include "entropy_tracker.h"
+#include "entropy.h"
+#include "parallel.h"
+
+const size_t tracker_chunk_size = 64;
+
+/************************************************************************
+ * Constructor - nothing is counted until the first sync
+ ***********************************************************************/
+
+entropy_tracker::entropy_tracker(const dictionary &dict)
+    : my_dict(dict), code_count(wordle_word::match_result::code_count())
+{
+}
+
+/************************************************************************
+ * usable - return true iff a tracker can be used for the dictionary,
+ * i.e. it has a pattern matrix covering all its words
+ ***********************************************************************/
+
+bool entropy_tracker::usable(const dictionary &dict)
+{
+    return dict.get_matrix().valid() && dict.get_matrix().size()==dict.size();
+}
+
+/************************************************************************
+ * sync - bring the histograms up to date for the given word list,
+ * either by adjusting them for the words which have come and gone
+ * since last time, or if there are more of those than words in the
+ * list (or the dictionary has changed), by counting from scratch.
+ ***********************************************************************/
+
+void entropy_tracker::sync(const word_list &wl)
+{
+    word_bitset now = wl.bits();
+    vector<word_index_t> removed;
+    vector<word_index_t> added;
+    if (filled && dict_size==my_dict.size()) {
+        word_bitset gone(tracked);
+        gone.and_not(now);
+        word_bitset come(now);
+        come.and_not(tracked);
+        if (gone.count() + come.count() <= wl.size()) {
+            gone.for_each([&](word_bitset::index_t i){ removed.push_back(i); });
+            come.for_each([&](word_bitset::index_t i){ added.push_back(i); });
+            update(removed, added);
+            tracked = std::move(now);
+            return;
+        }
+    }
+    dict_size = my_dict.size();
+    counts.assign(dict_size * code_count, 0);
+    now.for_each([&](word_bitset::index_t i){ added.push_back(i); });
+    update(removed, added);
+    tracked = std::move(now);
+    filled = true;
+}
+
+/************************************************************************
+ * update - adjust every guess's histogram for the given words leaving
+ * and joining the list. Each guess has its own histogram, so the
+ * guesses are shared out between threads.
+ ***********************************************************************/
+
+void entropy_tracker::update(const vector<word_index_t> &removed, const vector<word_index_t> &added)
+{
+    const pattern_matrix &pm = my_dict.get_matrix();
+    parallel::for_chunks(dict_size, parallel::thread_count(dict_size / tracker_chunk_size), tracker_chunk_size,
+                         [&](size_t, size_t b, size_t e) {
+                             for (size_t g : irange(b, e)) {
+                                 const pattern_matrix::code_t *row = pm.row(g);
+                                 U32 *c = &counts[g * code_count];
+                                 for (word_index_t w : removed) {
+                                     --c[row[w]];
+                                 }
+                                 for (word_index_t w : added) {
+                                     ++c[row[w]];
+                                 }
+                             }
+                         });
+}
+
+/************************************************************************
+ * entropy - return the entropy of the given word as a guess against
+ * the list at the last sync
+ ***********************************************************************/
+
+float entropy_tracker::entropy(word_index_t guess) const
+{
+    return ::entropy(&counts[size_t(guess) * code_count], code_count);
+}
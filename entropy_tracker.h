@@ -0,0 +1,47 @@
+#ifndef __ENTROPY_TRACKER
+#define __ENTROPY_TRACKER
+
+#include "types.h"
+#include "dictionary.h"
+#include "word_list.h"
+#include "word_bitset.h"
+
+/************************************************************************
+ * entropy_tracker - the histogram of match codes for every dictionary
+ * word as a guess against a word list, kept up to date as the list
+ * changes rather than counted afresh each time.
+ *
+ * After a guess most of the work of best() is recounting histograms
+ * for words which are still in the list. Instead, sync() works out
+ * which words have left the list (and, after an undo, which have come
+ * back) since last time, and adjusts each histogram by just those.
+ * If that is more words than are in the new list, it is cheaper to
+ * count from scratch, and that is done instead.
+ *
+ * The codes come from the pattern_matrix, so the tracker is only used
+ * when there is one. It needs one count per code per dictionary word,
+ * about 12 MB for the English dictionary, so it is only used if asked
+ * for (--incremental).
+ ***********************************************************************/
+
+class entropy_tracker
+{
+public:
+    typedef dictionary::word_index_t word_index_t;
+private:
+    const dictionary &my_dict;
+    U32 code_count;
+    size_t dict_size = 0;
+    vector<U32> counts;                 // code_count per guess
+    word_bitset tracked;                // the words counted
+    bool filled = false;
+public:
+    entropy_tracker(const dictionary &dict);
+    static bool usable(const dictionary &dict);
+    void sync(const word_list &wl);
+    float entropy(word_index_t guess) const;
+private:
+    void update(const vector<word_index_t> &removed, const vector<word_index_t> &added);
+};
+
+#endif
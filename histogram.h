@@ -0,0 +1,82 @@
+#ifndef __HISTOGRAM
+#define __HISTOGRAM
+
+#include "types.h"
+#include <unordered_map>
+
+/************************************************************************
+ * histogram - counts of match codes, reusable without reallocating or
+ * zero-filling.
+ *
+ * For up to max_dense buckets the counts are held in a flat vector,
+ * and we remember which buckets have been touched so that start()
+ * only has to clear those. Beyond that the counts go in a hash map.
+ *
+ * values() returns just the non-zero counts, as required by the
+ * integer ::entropy kernel.
+ *
+ * scratch() returns a per-thread histogram, so that callers which
+ * don't want to manage their own don't allocate on every call.
+ ***********************************************************************/
+
+class histogram
+{
+public:
+    static constexpr U32 max_dense = 6561;      // 3^8
+private:
+    vector<U32> counts;
+    vector<U32> touched;
+    std::unordered_map<U32, U32> sparse_counts;
+    vector<U32> compacted;
+    bool dense = true;
+public:
+    void start(U32 bucket_count)
+    {
+        for (U32 b : touched) {
+            counts[b] = 0;
+        }
+        touched.clear();
+        sparse_counts.clear();
+        dense = bucket_count <= max_dense;
+        if (dense && counts.size() < bucket_count) {
+            counts.resize(bucket_count);
+        }
+    }
+    void add(U32 bucket)
+    {
+        if (likely(dense)) {
+            U32 &c = counts[bucket];
+            if (c==0) {
+                touched.push_back(bucket);
+            }
+            c += 1;
+        } else {
+            sparse_counts[bucket] += 1;
+        }
+    }
+    size_t size() const
+    {
+        return dense ? touched.size() : sparse_counts.size();
+    }
+    const vector<U32> &values()
+    {
+        compacted.clear();
+        if (dense) {
+            for (U32 b : touched) {
+                compacted.push_back(counts[b]);
+            }
+        } else {
+            for (const auto &c : sparse_counts) {
+                compacted.push_back(c.second);
+            }
+        }
+        return compacted;
+    }
+    static histogram &scratch()
+    {
+        static thread_local histogram h;
+        return h;
+    }
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "instrument.h"
+
+namespace instrument
+{
+    const char *counter_names[counter_count] = { "conforms", "entropy", "match" };
+
+    /*
+     * The time and TSC when the program started, to convert ticks to time
+     */
+    const auto start_time = steady_clock::now();
+    const U64 start_ticks = __rdtsc();
+
+    /************************************************************************
+     * name - return the name of a counter
+     ***********************************************************************/
+
+    const char *name(counter c)
+    {
+        return counter_names[c];
+    }
+
+    /************************************************************************
+     * totals::operator- - return the difference between two sets of
+     * totals, i.e. what happened between the two calls to collect()
+     ***********************************************************************/
+
+    totals totals::operator-(const totals &other) const
+    {
+        totals result;
+        result.ns_per_tick = ns_per_tick;
+        for (size_t c : irange(0ul, counters.size())) {
+            result.counters[c].calls = counters[c].calls - other.counters[c].calls;
+            result.counters[c].items = counters[c].items - other.counters[c].items;
+            result.counters[c].ticks = counters[c].ticks - other.counters[c].ticks;
+            result.counters[c].ns = result.counters[c].ticks * ns_per_tick;
+        }
+        return result;
+    }
+
+#ifdef NO_INSTRUMENTATION
+
+    totals collect()
+    {
+        return totals();
+    }
+
+    void set_sample_rate(U32 rate)
+    {
+    }
+
+#else
+
+    U32 sample_rate = 1;
+    thread_local thread_counters my_counters;
+
+    /*
+     * Every thread's counters, and the sum for threads which have finished
+     */
+    struct raw_total
+    {
+        U64 calls = 0;
+        U64 items = 0;
+        U64 ticks = 0;
+    };
+    mutex registry_mutex;
+    set<thread_counters*> live_counters;
+    array<raw_total, counter_count> retired;
+
+    /************************************************************************
+     * add_counters - add one thread's counters to a set of raw totals. The
+     * time for sampled calls is scaled up to all the calls.
+     ***********************************************************************/
+
+    void add_counters(array<raw_total, counter_count> &sums, const thread_counters &tc)
+    {
+        for (size_t c : irange(0ul, sums.size())) {
+            const auto &s = tc.slots[c];
+            U64 calls = s.calls.load(std::memory_order_relaxed);
+            U64 sampled = s.sampled.load(std::memory_order_relaxed);
+            sums[c].calls += calls;
+            sums[c].items += s.items.load(std::memory_order_relaxed);
+            if (sampled) {
+                U64 ticks = s.ticks.load(std::memory_order_relaxed);
+                sums[c].ticks += calls==sampled ? ticks : U64(double(ticks) * calls / sampled);
+            }
+        }
+    }
+
+    /************************************************************************
+     * thread_counters constructor and destructor - keep track of the live
+     * threads' counters, and keep the counts of those which have gone
+     ***********************************************************************/
+
+    thread_counters::thread_counters()
+    {
+        std::lock_guard<mutex> lock(registry_mutex);
+        live_counters.insert(this);
+    }
+
+    thread_counters::~thread_counters()
+    {
+        std::lock_guard<mutex> lock(registry_mutex);
+        add_counters(retired, *this);
+        live_counters.erase(this);
+    }
+
+    /************************************************************************
+     * collect - add up the counters for all threads, past and present,
+     * and convert the TSC ticks to time
+     ***********************************************************************/
+
+    totals collect()
+    {
+        array<raw_total, counter_count> sums;
+        {
+            std::lock_guard<mutex> lock(registry_mutex);
+            sums = retired;
+            for (const thread_counters *tc : live_counters) {
+                add_counters(sums, *tc);
+            }
+        }
+        U64 ticks = __rdtsc() - start_ticks;
+        double ns = duration_cast<nanoseconds>(steady_clock::now() - start_time).count();
+        totals result;
+        result.ns_per_tick = ticks ? ns / ticks : 0;
+        for (size_t c : irange(0ul, sums.size())) {
+            result.counters[c].calls = sums[c].calls;
+            result.counters[c].items = sums[c].items;
+            result.counters[c].ticks = sums[c].ticks;
+            result.counters[c].ns = sums[c].ticks * result.ns_per_tick;
+        }
+        return result;
+    }
+
+    /************************************************************************
+     * set_sample_rate - time one call in every 'rate'
+     ***********************************************************************/
+
+    void set_sample_rate(U32 rate)
+    {
+        sample_rate = std::max(rate, 1u);
+    }
+
+#endif
+};
@@ -0,0 +1,141 @@
+#ifndef __INSTRUMENT
+#define __INSTRUMENT
+
+#include "types.h"
+#include <atomic>
+#include <x86intrin.h>
+
+/************************************************************************
+ * instrument - counters for the time spent in the hot paths (matching,
+ * entropy and filtering), cheap enough to leave in all the time.
+ *
+ * A scope object, made at the start of the code to be measured, counts
+ * a call to its counter and reads the TSC, and when it goes out of scope
+ * reads it again and adds the difference. The caller can also count
+ * items, e.g. the words matched. Every thread has its own counters,
+ * which only it writes, so there is no locking or contention, and they
+ * are only added up when collect() is called. Counters for threads
+ * which have finished are kept in a global total.
+ *
+ * With a sample rate of n, only every n'th call is timed, and the time
+ * is scaled up accordingly. Calls and items are always counted.
+ *
+ * TSC ticks are converted to time when the counters are collected, by
+ * comparing the TSC with the clock since the program started. Ticks
+ * are added up as integers and times are doubles, since the totals
+ * grow for as long as the program runs and callers take differences
+ * between them. The totals keep the ticks as well, and the difference
+ * between two sets of totals is converted from the difference in
+ * ticks, using the later conversion, rather than by subtracting times
+ * converted at different rates.
+ *
+ * If built with NO_INSTRUMENTATION, scope does nothing and the
+ * counters are always zero.
+ ***********************************************************************/
+
+namespace instrument
+{
+    enum counter
+    {
+        conforms,
+        entropy,
+        match,
+        counter_count,
+    };
+
+    struct total
+    {
+        U64 calls = 0;
+        U64 items = 0;
+        U64 ticks = 0;
+        double ns = 0;
+    };
+
+    struct totals
+    {
+        array<total, counter_count> counters;
+        double ns_per_tick = 0;
+        const total &operator[](counter c) const
+        {
+            return counters[c];
+        }
+        totals operator-(const totals &other) const;
+    };
+
+    totals collect();
+    void set_sample_rate(U32 rate);
+    const char *name(counter c);
+
+#ifdef NO_INSTRUMENTATION
+
+    const bool enabled = false;
+
+    class scope
+    {
+    public:
+        scope(counter c) { };
+        void add_items(size_t n) { };
+    };
+
+#else
+
+    const bool enabled = true;
+
+    /*
+     * The counters for one thread. They are atomic only so that
+     * collect() can read them safely from another thread: since only
+     * the owning thread writes them, it can use plain loads and stores.
+     */
+    struct thread_counters
+    {
+        struct slot
+        {
+            std::atomic<U64> calls = 0;
+            std::atomic<U64> items = 0;
+            std::atomic<U64> sampled = 0;
+            std::atomic<U64> ticks = 0;
+        };
+        array<slot, counter_count> slots;
+        thread_counters();
+        ~thread_counters();
+    };
+
+    extern thread_local thread_counters my_counters;
+    extern U32 sample_rate;
+
+    inline void bump(std::atomic<U64> &c, U64 n)
+    {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    class scope
+    {
+    private:
+        thread_counters::slot &my_slot;
+        U64 start = 0;
+    public:
+        scope(counter c)
+            : my_slot(my_counters.slots[c])
+        {
+            bump(my_slot.calls, 1);
+            if (sample_rate <= 1 || my_slot.calls.load(std::memory_order_relaxed) % sample_rate==0) {
+                start = __rdtsc();
+            }
+        }
+        ~scope()
+        {
+            if (start) {
+                bump(my_slot.ticks, __rdtsc() - start);
+                bump(my_slot.sampled, 1);
+            }
+        }
+        void add_items(size_t n)
+        {
+            bump(my_slot.items, n);
+        }
+    };
+
+#endif
+};
+
+#endif
@@ -0,0 +1,346 @@
+#include "types.h"
+#include "dictionary.h"
+#include "word_list.h"
+#include "entropy.h"
+#include "formatted.h"
+#include <random>
+#include <iostream>
+
+/************************************************************************
+ * cwordle_bench - time the kernels everything else is built on, using
+ * the real dictionaries in languages/.
+ *
+ * For each language, words are sampled from the dictionary with a fixed
+ * seed, so every run times the same work. Each kernel is run for a few
+ * warm-up batches, then for as many batches as fit in the time given
+ * by --time, and one JSON object is written to stdout on a line of its
+ * own, giving the time per operation and the throughput, e.g.
+ *
+ * {"kernel":"match","language":"english","length":5,"words":12972,
+ *  "seed":1,"ops":1048576,"ns_per_op":21.4,"items_per_op":1,
+ *  "items_per_sec":4.7e+07}
+ *
+ * An item is whatever the kernel works through: a word for match,
+ * conforms, set_word and filter, a histogram bin for entropy. Anything
+ * else is written to stderr so the output can be saved as it is and
+ * compared between builds.
+ ***********************************************************************/
+
+const size_t sample_pairs = 4096;
+const size_t sample_targets = 64;
+const size_t sample_candidates = 256;
+const size_t sample_histograms = 64;
+const size_t sample_filters = 16;
+
+class kernel_bench
+{
+private:
+    const dictionary &my_dict;
+    string my_language;
+    unsigned my_seed;
+    int my_warmup;
+    float my_time;
+    string my_kernel;
+    std::mt19937 engine;
+    vector<pair<dictionary::word_index_t, dictionary::word_index_t>> pairs;
+    U64 sink = 0;
+public:
+    kernel_bench(const dictionary &dict, const string &lang, unsigned seed,
+                 int warmup, int time, const string &kernel);
+    void run();
+    U64 get_sink() const
+    {
+        return sink;
+    }
+private:
+    template<class FN>
+    void measure(const string &kernel, size_t ops, size_t items_per_op, FN fn);
+    dictionary::word_index_t random_word()
+    {
+        return std::uniform_int_distribution<dictionary::word_index_t>(0, my_dict.size() - 1)(engine);
+    }
+    void bench_match();
+    void bench_conforms();
+    void bench_entropy();
+    void bench_filter();
+    void bench_set_word();
+};
+
+/************************************************************************
+ * Constructor - pick the (guess, answer) pairs used by the kernels
+ ***********************************************************************/
+
+kernel_bench::kernel_bench(const dictionary &dict, const string &lang, unsigned seed,
+                           int warmup, int time, const string &kernel)
+    : my_dict(dict), my_language(lang), my_seed(seed), my_warmup(warmup),
+      my_time(time * 1e6), my_kernel(kernel), engine(seed)
+{
+    for (size_t i : irange(0ul, sample_pairs)) {
+        pairs.emplace_back(random_word(), random_word());
+    }
+}
+
+/************************************************************************
+ * run - time all the kernels
+ ***********************************************************************/
+
+void kernel_bench::run()
+{
+    bench_match();
+    bench_conforms();
+    bench_entropy();
+    bench_filter();
+    bench_set_word();
+}
+
+/************************************************************************
+ * measure - time a kernel, unless --kernel names some other one. 'fn'
+ * does one batch of 'ops' operations and returns something depending
+ * on all of them, which is added to the sink so the work can't be
+ * optimised away.
+ ***********************************************************************/
+
+template<class FN>
+void kernel_bench::measure(const string &kernel, size_t ops, size_t items_per_op, FN fn)
+{
+    if (!my_kernel.empty() && !kernel.starts_with(my_kernel)) {
+        return;
+    }
+    for (int i : irange(0, my_warmup)) {
+        sink += fn();
+    }
+    size_t batches = 0;
+    float elapsed = 0;
+    auto start = high_resolution_clock::now();
+    do {
+        sink += fn();
+        ++batches;
+        elapsed = duration_cast<nanoseconds>(high_resolution_clock::now() - start).count();
+    } while (elapsed < my_time);
+    size_t total = batches * ops;
+    float ns_per_op = elapsed / total;
+    cout << formatted("{\"kernel\":\"%s\",\"language\":\"%s\",\"length\":%d,\"words\":%d,"
+                      "\"seed\":%d,\"ops\":%d,\"ns_per_op\":%.3f,\"items_per_op\":%d,"
+                      "\"items_per_sec\":%.4g}\n",
+                      kernel, my_language, word_length, my_dict.size(),
+                      my_seed, total, ns_per_op, items_per_op,
+                      items_per_op * 1e9 / ns_per_op) << std::flush;
+}
+
+/************************************************************************
+ * bench_match - wordle_word::match, i.e. do_match, for each pair
+ ***********************************************************************/
+
+void kernel_bench::bench_match()
+{
+    measure("match", pairs.size(), 1, [&]() {
+        U64 result = 0;
+        for (const auto &p : pairs) {
+            result += my_dict[p.first].match(my_dict[p.second]).get_code();
+        }
+        return result;
+    });
+}
+
+/************************************************************************
+ * bench_conforms - match_target::conforms and conforms_exact for some
+ * targets, each against the same sample of candidates
+ ***********************************************************************/
+
+void kernel_bench::bench_conforms()
+{
+    vector<wordle_word::match_target> targets;
+    for (size_t i : irange(0ul, sample_targets)) {
+        const auto &p = pairs[i];
+        targets.emplace_back(my_dict[p.first], my_dict[p.first].match(my_dict[p.second]));
+    }
+    vector<const wordle_word*> candidates;
+    for (size_t i : irange(0ul, sample_candidates)) {
+        candidates.push_back(&my_dict[random_word()]);
+    }
+    measure("conforms", targets.size() * candidates.size(), 1, [&]() {
+        U64 result = 0;
+        for (const auto &t : targets) {
+            for (const wordle_word *c : candidates) {
+                result += t.conforms(*c);
+            }
+        }
+        return result;
+    });
+    measure("conforms_exact", targets.size() * candidates.size(), 1, [&]() {
+        U64 result = 0;
+        for (const auto &t : targets) {
+            for (const wordle_word *c : candidates) {
+                result += t.conforms_exact(c->str());
+            }
+        }
+        return result;
+    });
+}
+
+/************************************************************************
+ * bench_entropy - the entropy functions, for the histograms of match
+ * codes given by some guesses against the whole dictionary. The float
+ * versions get the same counts, padded to a multiple of 8 for AVX.
+ ***********************************************************************/
+
+void kernel_bench::bench_entropy()
+{
+    U32 code_count = wordle_word::match_result::code_count();
+    size_t padded = (code_count + 7) & ~7ul;
+    vector<vector<U32>> counts;
+    vector<vector<float>> float_counts;
+    for (size_t i : irange(0ul, sample_histograms)) {
+        const wordle_word &guess = my_dict[pairs[i].first];
+        vector<U32> c(code_count, 0);
+        for (const auto &w : my_dict) {
+            ++c[guess.match(w).get_code()];
+        }
+        float_counts.emplace_back(c.begin(), c.end());
+        float_counts.back().resize(padded, 0);
+        counts.emplace_back(std::move(c));
+    }
+    auto float_kernel = [&](const string &name, float (*fn)(const vector<float>&)) {
+        measure(name, float_counts.size(), padded, [&]() {
+            float result = 0;
+            for (const auto &fc : float_counts) {
+                result += fn(fc);
+            }
+            return U64(result);
+        });
+    };
+    float_kernel("entropy", ::entropy);
+    float_kernel("entropy_slow", entropy_slow);
+    float_kernel("entropy_slowest", entropy_slowest);
+    measure("entropy_table", counts.size(), code_count, [&]() {
+        float result = 0;
+        for (const auto &c : counts) {
+            result += ::entropy(c.data(), c.size());
+        }
+        return U64(result);
+    });
+}
+
+/************************************************************************
+ * bench_filter - the word_list filters, each from the whole dictionary.
+ * The pattern matrix version is only timed if there is a matrix.
+ ***********************************************************************/
+
+void kernel_bench::bench_filter()
+{
+    word_list all(my_dict);
+    all.begin();
+    vector<pair<dictionary::word_index_t, wordle_word::match_target>> targets;
+    for (size_t i : irange(0ul, sample_filters)) {
+        const auto &p = pairs[i];
+        targets.emplace_back(p.first,
+                             wordle_word::match_target(my_dict[p.first], my_dict[p.first].match(my_dict[p.second])));
+    }
+    measure("filter", targets.size(), all.size(), [&]() {
+        U64 result = 0;
+        for (const auto &t : targets) {
+            result += all.filter(t.second).size();
+        }
+        return result;
+    });
+    measure("filter_exact", targets.size(), all.size(), [&]() {
+        U64 result = 0;
+        for (const auto &t : targets) {
+            result += all.filter_exact(t.second).size();
+        }
+        return result;
+    });
+    if (my_dict.get_matrix().valid()) {
+        measure("filter_matrix", targets.size(), all.size(), [&]() {
+            U64 result = 0;
+            for (const auto &t : targets) {
+                result += all.filter(t.first, t.second.get_result()).size();
+            }
+            return result;
+        });
+    }
+}
+
+/************************************************************************
+ * bench_set_word - the three ways of making a wordle_word from its
+ * text, for each of the sampled words
+ ***********************************************************************/
+
+void kernel_bench::bench_set_word()
+{
+    vector<string> texts;
+    for (const auto &p : pairs) {
+        texts.emplace_back(my_dict[p.first].str());
+    }
+    auto set_word_kernel = [&](const string &name, void (wordle_word::*fn)(const string_view&)) {
+        measure(name, texts.size(), 1, [&]() {
+            U64 result = 0;
+            wordle_word w;
+            for (const auto &t : texts) {
+                (w.*fn)(t);
+                result += w.get_all_letters().get();
+            }
+            return result;
+        });
+    };
+    set_word_kernel("set_word_basic", &wordle_word::set_word_basic);
+    set_word_kernel("set_word_2", &wordle_word::set_word_2);
+    set_word_kernel("set_word", &wordle_word::set_word);
+}
+
+/************************************************************************
+ * Main program - load each language's dictionary and time the kernels
+ * against it
+ ***********************************************************************/
+
+int main(int argc, char *argv[])
+{
+    po::options_description od("Available options");
+    po::variables_map vm;
+    od.add_options()
+        ("help,h", "produce help message")
+        ("kernel,k", po::value<string>()->default_value(""), "only time kernels whose names start with this")
+        ("language,L", po::value<vector<string>>()->multitoken(), "languages to use (default english)")
+        ("length,l", po::value<int>()->default_value(DEFAULT_WORD_LENGTH), "word length")
+        ("matrix,m", "precompute the pattern matrix, to time filtering with it")
+        ("path,p", po::value<string>()->default_value(DEFAULT_PATH), "path to language dictionaries")
+        ("seed,s", po::value<unsigned>()->default_value(1), "random seed for choosing words")
+        ("time,t", po::value<int>()->default_value(200), "time in mS to run each kernel")
+        ("warmup,w", po::value<int>()->default_value(3), "batches to run before timing each kernel");
+    try {
+        po::store(po::parse_command_line(argc, argv, od), vm);
+    } catch (std::exception &exc) {
+        std::cerr << "Error in command line: " << exc.what() << '\n';
+        return 1;
+    }
+    po::notify(vm);
+    if (vm.count("help") > 0) {
+        cout << od << '\n';
+        return 1;
+    }
+    word_length = vm["length"].as<int>();
+    string path = vm["path"].as<string>();
+    if (!path.ends_with("/")) {
+        path += '/';
+    }
+    vector<string> languages = vm.count("language") > 0
+        ? vm["language"].as<vector<string>>()
+        : vector<string>{ DEFAULT_LANGUAGE };
+    for (const auto &lang : languages) {
+        dictionary dict;
+        string dict_file = path + lang + "/words.txt";
+        if (!dict.load_file(dict_file) || dict.size()==0) {
+            std::cerr << formatted("Failed to load %d letter words from '%s'\n", word_length, dict_file);
+            return 1;
+        }
+        std::cerr << formatted("Loaded %d words from '%s'\n", dict.size(), dict_file);
+        if (vm.count("matrix") > 0 && !dict.build_matrix()) {
+            std::cerr << formatted("Pattern matrix is not available for %d letter words\n", word_length);
+        }
+        kernel_bench bench(dict, lang, vm["seed"].as<unsigned>(), vm["warmup"].as<int>(),
+                           vm["time"].as<int>(), vm["kernel"].as<string>());
+        bench.run();
+        std::cerr << formatted("Checksum %d\n", bench.get_sink());
+    }
+    return 0;
+}
@@ -2,7 +2,12 @@
 #include "formatted.h"
 #include "styled_text.h"
 #include "commands.h"
-#include "timers.h"
+#include "timing_reporter.h"
+#include "instrument.h"
+#include "best_cache.h"
+#include "best_lru.h"
+#include "decision_tree.h"
+#include "benchmark.h"
 #include <istream>
 #include <fstream>
 #include <sstream>
@@ -137,25 +142,105 @@ bool load_dict()
 
 int run()
 {
-    dictionary::init();
-    the_wordle = new cwordle(the_dictionary);
     word_length = options["length"].as<int>();
     max_guesses = options["guesses"].as<int>();
-    the_path = options["path"].as<string>();
-    if (!algorithm::ends_with(the_path, "/")) {
-        the_path += '/';
+    max_threads = options["threads"].as<int>();
+    incremental_entropy = options.count("incremental") > 0;
+    instrument::set_sample_rate(options["time-sample"].as<int>());
+    sutom_mode = options.count("sutom") > 0;
+    strict_mode = sutom_mode || options.count("strict") > 0;
+    string image = options["image"].as<string>();
+    if (!image.empty()) {
+        timing_reporter tr;
+        the_dictionary = new dictionary();
+        if (!the_dictionary->load_image(image)) {
+            cout << formatted("Failed to load dictionary image '%s'\n", image);
+            return 1;
+        }
+        the_wordle = new cwordle(the_dictionary);
+        cout << formatted("Loaded %d words of length %d from image '%s' in %s\n",
+                          the_dictionary->size(), word_length, image, tr.show_time());
+    } else {
+        dictionary::init();
+        the_wordle = new cwordle(the_dictionary);
+        the_path = options["path"].as<string>();
+        if (!algorithm::ends_with(the_path, "/")) {
+            the_path += '/';
+        }
+        string lang(algorithm::to_lower_copy(options["language"].as<string>()));
+        if (!lang.empty()) {
+            the_language = choose_language(lang);
+            if (the_language.empty()) {
+                return 1;
+            }
+        }
+        if (!load_dict()) {
+            return 1;
+        }
     }
-    string lang(algorithm::to_lower_copy(options["language"].as<string>()));
-    if (!lang.empty()) {
-        the_language = choose_language(lang);
-        if (the_language.empty()) {
+    if (options.count("matrix") > 0 && !the_dictionary->get_matrix().valid()) {
+        timing_reporter tr;
+        if (the_dictionary->build_matrix()) {
+            cout << formatted("Built %d x %d pattern matrix in %s\n",
+                              the_dictionary->size(), the_dictionary->size(), tr.show_time());
+        } else {
+            cout << formatted("Pattern matrix is not available for %d letter words\n", word_length);
+        }
+    }
+    string write_image = options["write-image"].as<string>();
+    if (!write_image.empty()) {
+        if (!the_dictionary->write_image(write_image)) {
+            cout << formatted("Failed to write dictionary image '%s'\n", write_image);
             return 1;
         }
+        cout << formatted("Wrote %d words to image '%s'\n", the_dictionary->size(), write_image);
+        return 0;
     }
-    sutom_mode = options.count("sutom") > 0;
-    strict_mode = sutom_mode || options.count("strict") > 0;
-    if (!load_dict()) {
-        return 1;
+    string write_tree = options["write-tree"].as<string>();
+    if (!write_tree.empty()) {
+        timing_reporter tr;
+        decision_tree tree(*the_dictionary);
+        tree.build(options["tree-width"].as<int>());
+        if (!tree.save(write_tree)) {
+            cout << formatted("Failed to write decision tree '%s'\n", write_tree);
+            return 1;
+        }
+        const auto &st = tree.get_stats();
+        cout << formatted("Wrote decision tree of %d nodes to '%s' in %s\n", st.nodes, write_tree, tr.show_time());
+        cout << formatted("%d answers take %.3f guesses on average, at most %d\n", st.answers,
+                          st.answers ? float(st.total_guesses) / st.answers : 0.0f, st.max_guesses);
+        return 0;
+    }
+    string tree_file = options["tree"].as<string>();
+    if (!tree_file.empty()) {
+        the_decision_tree = new decision_tree(*the_dictionary);
+        if (!the_decision_tree->load(tree_file)) {
+            cout << formatted("Failed to load decision tree '%s'\n", tree_file);
+            return 1;
+        }
+        cout << formatted("Loaded decision tree of %d nodes from '%s'\n", the_decision_tree->size(), tree_file);
+    }
+    string cache_file = options["cache"].as<string>();
+    if (!cache_file.empty()) {
+        the_best_cache = new best_cache(*the_dictionary);
+        if (!the_best_cache->open(cache_file)) {
+            cout << formatted("Failed to open cache file '%s'\n", cache_file);
+            return 1;
+        }
+        cout << formatted("Loaded %d cached results from '%s'\n", the_best_cache->size(), cache_file);
+        if (!the_best_cache->has_openers()) {
+            cout << "Finding the best openers for the cache\n";
+            cwordle(the_dictionary).best(best_cache::opener_count);
+        }
+    }
+    if (options["memo"].as<int>() > 0) {
+        the_best_lru = new best_lru(*the_dictionary, size_t(options["memo"].as<int>()) << 20);
+    }
+    if (options.count("bench") > 0) {
+        benchmark bench(*the_dictionary);
+        bench.run();
+        cout << bench.report();
+        return 0;
     }
     commands cmds;
     the_commands = &cmds;
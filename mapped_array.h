@@ -0,0 +1,133 @@
+#ifndef __MAPPED_ARRAY
+#define __MAPPED_ARRAY
+
+#include "types.h"
+
+/************************************************************************
+ * mapped_array - an array which either owns its contents, like a
+ * vector, or refers to memory it doesn't own, typically part of a
+ * memory mapped file (see dictionary::load_image).
+ *
+ * The mapped contents are read only. Any change copies them into
+ * owned memory first, and from then on the array behaves as an
+ * ordinary vector.
+ *
+ * T must be trivially copyable, since mapped contents are just the
+ * bytes of the values.
+ ***********************************************************************/
+
+template<class T>
+class mapped_array
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+private:
+    vector<T> owned;
+    const T *mapped = nullptr;
+    size_t mapped_size = 0;
+public:
+    typedef const T *const_iterator;
+    size_t size() const
+    {
+        return mapped ? mapped_size : owned.size();
+    }
+    bool empty() const
+    {
+        return size()==0;
+    }
+    bool is_mapped() const
+    {
+        return mapped != nullptr;
+    }
+    const T *data() const
+    {
+        return mapped ? mapped : owned.data();
+    }
+    T *mutable_data()
+    {
+        unmap();
+        return owned.data();
+    }
+    const T &operator[](size_t i) const
+    {
+        return data()[i];
+    }
+    const T &front() const
+    {
+        return data()[0];
+    }
+    const T &back() const
+    {
+        return data()[size() - 1];
+    }
+    const_iterator begin() const
+    {
+        return data();
+    }
+    const_iterator end() const
+    {
+        return data() + size();
+    }
+    void map(const T *d, size_t sz)
+    {
+        owned.clear();
+        owned.shrink_to_fit();
+        mapped = d;
+        mapped_size = sz;
+    }
+    void set(size_t i, const T &value)
+    {
+        unmap();
+        owned[i] = value;
+    }
+    void push_back(const T &value)
+    {
+        unmap();
+        owned.push_back(value);
+    }
+    template<class... ARGS>
+    void emplace_back(ARGS&&... args)
+    {
+        unmap();
+        owned.emplace_back(std::forward<ARGS>(args)...);
+    }
+    void reserve(size_t sz)
+    {
+        unmap();
+        owned.reserve(sz);
+    }
+    void resize(size_t sz, const T &value=T())
+    {
+        unmap();
+        owned.resize(sz, value);
+    }
+    void assign(size_t sz, const T &value)
+    {
+        mapped = nullptr;
+        mapped_size = 0;
+        owned.assign(sz, value);
+    }
+    void swap(vector<T> &other)
+    {
+        mapped = nullptr;
+        mapped_size = 0;
+        owned.swap(other);
+    }
+    void clear()
+    {
+        mapped = nullptr;
+        mapped_size = 0;
+        owned.clear();
+        owned.shrink_to_fit();
+    }
+private:
+    void unmap()
+    {
+        if (mapped) {
+            owned.assign(mapped, mapped + mapped_size);
+            mapped = nullptr;
+            mapped_size = 0;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,292 @@
+#include "match_view.h"
+#include <immintrin.h>
+
+/************************************************************************
+ * probe constructors - from a wordle_word, or from a word already
+ * in the view
+ ***********************************************************************/
+
+match_view::probe::probe(const wordle_word &w)
+{
+    word_mask wm = w.get_exact_mask();
+    for (size_t i=0; i<size_t(word_length); ++i) {
+        letters[i] = wm[i].get();
+    }
+    all_letters = w.get_all_letters().get();
+    repeated_letters = (w.get_twice_letters() | w.get_many_letters()).get();
+}
+
+match_view::probe::probe(const match_view &view, index_t idx)
+{
+    for (size_t i=0; i<size_t(word_length); ++i) {
+        letters[i] = view.position_letters[i][idx];
+    }
+    all_letters = view.all_letters[idx];
+    repeated_letters = view.repeated_letters[idx];
+}
+
+/************************************************************************
+ * clear and append - the view is maintained by the dictionary, which
+ * appends each word as it is inserted
+ ***********************************************************************/
+
+void match_view::clear()
+{
+    for (auto &p : position_letters) {
+        p.clear();
+    }
+    all_letters.clear();
+    repeated_letters.clear();
+}
+
+void match_view::append(const wordle_word &w)
+{
+    probe p(w);
+    for (size_t i=0; i<size_t(word_length); ++i) {
+        position_letters[i].push_back(p.letters[i]);
+    }
+    all_letters.push_back(p.all_letters);
+    repeated_letters.push_back(p.repeated_letters);
+}
+
+/************************************************************************
+ * map - use arrays from a dictionary image
+ ***********************************************************************/
+
+void match_view::map(const array<const U32*, MAX_WORD_LENGTH> &positions, const U32 *all,
+                     const U32 *repeated, size_t sz)
+{
+    clear();
+    for (size_t i=0; i<size_t(word_length); ++i) {
+        position_letters[i].map(positions[i], sz);
+    }
+    all_letters.map(all, sz);
+    repeated_letters.map(repeated, sz);
+}
+
+/************************************************************************
+ * match_code_repeated - match_code for guesses with repeated letters.
+ *
+ * Letters which occur once in the guess are handled as in match_code.
+ * For each repeated letter, we count the occurrences in the answer
+ * which are not exact matches. That many of the non-exact occurrences
+ * in the guess are partial matches, taking them from left to right.
+ ***********************************************************************/
+
+U32 match_view::match_code_repeated(const probe &guess, index_t answer) const
+{
+    U32 answer_letters = all_letters[answer];
+    U32 result = 0;
+    U32 exact = 0;
+    for (size_t i=0; i<size_t(word_length); ++i) {
+        U32 g = guess.letters[i];
+        if (g==position_letters[i][answer]) {
+            exact |= 1 << i;
+            result += 2 * powers_of_3[i];
+        } else if ((g & answer_letters) && !(g & guess.repeated_letters)) {
+            result += powers_of_3[i];
+        }
+    }
+    for (const auto *m : letter_mask(guess.repeated_letters & answer_letters)) {
+        U32 lm = m->get();
+        U32 available = 0;
+        for (size_t i=0; i<size_t(word_length); ++i) {
+            if (position_letters[i][answer]==lm && !(exact & (1 << i))) {
+                ++available;
+            }
+        }
+        for (size_t i=0; i<size_t(word_length) && available>0; ++i) {
+            if (guess.letters[i]==lm && !(exact & (1 << i))) {
+                result += powers_of_3[i];
+                --available;
+            }
+        }
+    }
+    return result;
+}
+
+/************************************************************************
+ * match_many - calculate the match codes of the guess against each of
+ * the given answers, storing them in out_codes.
+ *
+ * With AVX512 this does 16 answers at a time, one per 32-bit lane,
+ * gathering each answer's letters from the view. The logic is the same
+ * as match_code: for letters which appear once in the guess, the digit
+ * is the sum of the exact test and the contains test. Repeated guess
+ * letters score exact matches first, then for each such letter we
+ * count the answer's unmatched occurrences in every lane, and hand
+ * them out as partial matches from left to right.
+ ***********************************************************************/
+
+void match_view::match_many(const probe &guess, std::span<const index_t> answers, U32 *out_codes) const
+{
+#ifdef AVX512
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i ones = _mm512_set1_epi32(1);
+    const int *all_base = reinterpret_cast<const int*>(all_letters.data());
+    for (size_t k = 0; k < answers.size(); k += 16) {
+        __mmask16 lanes = answers.size() - k >= 16 ? 0xffff : (1 << (answers.size() - k)) - 1;
+        __m512i idx = _mm512_maskz_loadu_epi32(lanes, &answers[k]);
+        __m512i answer_letters = _mm512_mask_i32gather_epi32(zero, lanes, idx, all_base, 4);
+        __m512i result = zero;
+        __m512i letters[MAX_WORD_LENGTH];
+        __mmask16 exact[MAX_WORD_LENGTH];
+        for (size_t i=0; i<size_t(word_length); ++i) {
+            const int *base = reinterpret_cast<const int*>(position_letters[i].data());
+            letters[i] = _mm512_mask_i32gather_epi32(zero, lanes, idx, base, 4);
+            __m512i g = _mm512_set1_epi32(guess.letters[i]);
+            __m512i power = _mm512_set1_epi32(powers_of_3[i]);
+            exact[i] = _mm512_cmpeq_epi32_mask(letters[i], g);
+            result = _mm512_mask_add_epi32(result, exact[i], result, power);
+            if (guess.letters[i] & guess.repeated_letters) {
+                result = _mm512_mask_add_epi32(result, exact[i], result, power);
+            } else {
+                __mmask16 contains = _mm512_test_epi32_mask(answer_letters, g);
+                result = _mm512_mask_add_epi32(result, contains, result, power);
+            }
+        }
+        for (const auto *m : letter_mask(guess.repeated_letters)) {
+            __m512i lm = _mm512_set1_epi32(m->get());
+            __m512i available = zero;
+            for (size_t i=0; i<size_t(word_length); ++i) {
+                __mmask16 unmatched = _mm512_cmpeq_epi32_mask(letters[i], lm) & ~exact[i];
+                available = _mm512_mask_add_epi32(available, unmatched, available, ones);
+            }
+            for (size_t i=0; i<size_t(word_length); ++i) {
+                if (guess.letters[i]==m->get()) {
+                    __mmask16 partial = _mm512_cmpgt_epi32_mask(available, zero) & ~exact[i];
+                    result = _mm512_mask_add_epi32(result, partial, result, _mm512_set1_epi32(powers_of_3[i]));
+                    available = _mm512_mask_sub_epi32(available, partial, available, ones);
+                }
+            }
+        }
+        _mm512_mask_storeu_epi32(out_codes + k, lanes, result);
+    }
+#else
+    for (size_t k : irange(0ul, answers.size())) {
+        out_codes[k] = match_code(guess, answers[k]);
+    }
+#endif
+}
+
+/************************************************************************
+ * filter_many - apply match_target::conforms to each of the candidates,
+ * writing the ones that conform to out_survivors (which may be the
+ * same as the candidates) and returning how many there are.
+ *
+ * With AVX512 this does 16 candidates at a time, using the same tests
+ * as conforms() (see there for the details), each giving a lane mask:
+ *
+ * 1. No absent letters, and all required letters.
+ * 2. The right letter at each exact position, and not the partially
+ *    matched letter at each partial position.
+ * 3. For each repeated letter, the right count at the non-exact
+ *    positions.
+ *
+ * The survivors are then written out with a compress-store.
+ ***********************************************************************/
+
+size_t match_view::filter_many(const wordle_word::match_target &mt, std::span<const index_t> candidates,
+                               index_t *out_survivors) const
+{
+    size_t result = 0;
+#ifdef AVX512
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i ones = _mm512_set1_epi32(1);
+    const __m512i absent = _mm512_set1_epi32(mt.absent_letters.get());
+    const __m512i required = _mm512_set1_epi32(mt.required_letters.get());
+    const int *all_base = reinterpret_cast<const int*>(all_letters.data());
+    for (size_t k = 0; k < candidates.size(); k += 16) {
+        __mmask16 lanes = candidates.size() - k >= 16 ? 0xffff : (1 << (candidates.size() - k)) - 1;
+        __m512i idx = _mm512_maskz_loadu_epi32(lanes, &candidates[k]);
+        __m512i candidate_letters = _mm512_mask_i32gather_epi32(zero, lanes, idx, all_base, 4);
+        __mmask16 ok = lanes & _mm512_testn_epi32_mask(candidate_letters, absent);
+        ok &= _mm512_cmpeq_epi32_mask(_mm512_and_si512(candidate_letters, required), required);
+        __m512i letters[MAX_WORD_LENGTH];
+        for (size_t i=0; i<size_t(word_length) && ok; ++i) {
+            const int *base = reinterpret_cast<const int*>(position_letters[i].data());
+            letters[i] = _mm512_mask_i32gather_epi32(zero, ok, idx, base, 4);
+            if (U32 e = mt.exact_mask[i].get()) {
+                ok &= _mm512_cmpeq_epi32_mask(letters[i], _mm512_set1_epi32(e));
+            }
+            if (U32 p = mt.only_partial_mask[i].get()) {
+                ok &= _mm512_cmpneq_epi32_mask(letters[i], _mm512_set1_epi32(p));
+            }
+        }
+        for (const auto &lt : mt.letter_targets) {
+            if (!ok) {
+                break;
+            }
+            __m512i count = zero;
+            for (size_t i=0; i<size_t(word_length); ++i) {
+                if (U32 l = lt.mask[i].get()) {
+                    __mmask16 here = _mm512_cmpeq_epi32_mask(letters[i], _mm512_set1_epi32(l));
+                    count = _mm512_mask_add_epi32(count, here, count, ones);
+                }
+            }
+            __m512i target = _mm512_set1_epi32(lt.count);
+            ok &= lt.greater_ok ? _mm512_cmpge_epi32_mask(count, target)
+                                : _mm512_cmpeq_epi32_mask(count, target);
+        }
+        _mm512_mask_compressstoreu_epi32(out_survivors + result, ok, idx);
+        result += __builtin_popcount(ok);
+    }
+#else
+    for (index_t c : candidates) {
+        bool ok = !(all_letters[c] & mt.absent_letters.get())
+            && (all_letters[c] & mt.required_letters.get())==mt.required_letters.get();
+        for (size_t i=0; i<size_t(word_length) && ok; ++i) {
+            U32 l = position_letters[i][c];
+            ok = (!mt.exact_mask[i] || l==mt.exact_mask[i].get())
+                && l!=mt.only_partial_mask[i].get();
+        }
+        for (const auto &lt : mt.letter_targets) {
+            if (!ok) {
+                break;
+            }
+            U32 count = 0;
+            for (size_t i=0; i<size_t(word_length); ++i) {
+                count += lt.mask[i] && position_letters[i][c]==lt.mask[i].get();
+            }
+            ok = lt.greater_ok ? count >= lt.count : count == lt.count;
+        }
+        if (ok) {
+            out_survivors[result++] = c;
+        }
+    }
+#endif
+    return result;
+}
+
+/************************************************************************
+ * filter_many - as above, but keep just the candidates which conform
+ * to all of an array of compact targets. Each target in turn is played
+ * against the survivors so far, a block at a time with match_many, and
+ * those giving its code are kept, in place.
+ ***********************************************************************/
+
+const size_t filter_block_size = 256;
+
+size_t match_view::filter_many(std::span<const target> targets, std::span<const index_t> candidates,
+                               index_t *out_survivors) const
+{
+    size_t result = candidates.size();
+    if (out_survivors != candidates.data()) {
+        std::copy(candidates.begin(), candidates.end(), out_survivors);
+    }
+    U32 codes[filter_block_size];
+    for (const target &t : targets) {
+        size_t kept = 0;
+        for (size_t b = 0; b < result; b += filter_block_size) {
+            size_t n = std::min(filter_block_size, result - b);
+            match_many(t.guess, std::span<const index_t>(out_survivors + b, n), codes);
+            for (size_t i : irange(0ul, n)) {
+                if (codes[i]==t.code) {
+                    out_survivors[kept++] = out_survivors[b + i];
+                }
+            }
+        }
+        result = kept;
+    }
+    return result;
+}
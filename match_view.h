@@ -0,0 +1,144 @@
+#ifndef __MATCH_VIEW
+#define __MATCH_VIEW
+
+#include "types.h"
+#include "wordle_word.h"
+#include "mapped_array.h"
+#include <span>
+
+/************************************************************************
+ * match_view - a packed structure-of-arrays copy of just the parts of
+ * the dictionary words needed to compute match codes.
+ *
+ * A wordle_word is several hundred bytes, almost all of it word_masks
+ * used by conforms() and friends. To match a guess against a long run
+ * of answers we only need, for each answer, the letter at each position
+ * and the set of letters present. Holding those in separate contiguous
+ * arrays means the match loop streams through a few tens of KB
+ * instead of striding across MB of wordle_words.
+ *
+ * Letters are held as one-hot letter_mask values, one array per
+ * position.
+ *
+ * A probe is the guess side of the match, prepared once and then
+ * matched against many answers, either one at a time (match_code)
+ * or in bulk (match_many).
+ *
+ * The same data also allows a match_target, or an array of the
+ * compact targets below, to be applied to many words at once
+ * (filter_many).
+ *
+ * Only the first word_length position arrays are used. All the arrays
+ * can be mapped from a dictionary image.
+ ***********************************************************************/
+
+class match_view
+{
+public:
+    typedef U32 index_t;
+    struct probe
+    {
+        array<U32, MAX_WORD_LENGTH> letters = {};
+        U32 all_letters = 0;
+        U32 repeated_letters = 0;
+        probe() { };
+        probe(const wordle_word &w);
+        probe(const match_view &view, index_t idx);
+    };
+    /*
+     * target - a compact, fixed size form of a match_target: the guess
+     * as a probe, and the code of its result. A word conforms iff the
+     * guess played against it gives the same code. Being plain data,
+     * these can be held in arrays and applied together by filter_many.
+     */
+    struct target
+    {
+        probe guess;
+        U32 code = 0;
+        target() { };
+        target(const wordle_word &w, const wordle_word::match_result &mr)
+            : guess(w), code(mr.get_code()) { };
+        target(const match_view &view, index_t idx, const wordle_word::match_result &mr)
+            : guess(view, idx), code(mr.get_code()) { };
+    };
+    static constexpr array<U32, MAX_WORD_LENGTH> powers_of_3 = []() {
+        array<U32, MAX_WORD_LENGTH> result;
+        U32 p = 1;
+        for (U32 &r : result) {
+            r = p;
+            p *= 3;
+        }
+        return result;
+    }();
+private:
+    array<mapped_array<U32>, MAX_WORD_LENGTH> position_letters;
+    mapped_array<U32> all_letters;
+    mapped_array<U32> repeated_letters;
+public:
+    size_t size() const
+    {
+        return all_letters.size();
+    }
+    void clear();
+    void append(const wordle_word &w);
+    const U32 *get_position_letters(size_t pos) const
+    {
+        return position_letters[pos].data();
+    }
+    const U32 *get_all_letters() const
+    {
+        return all_letters.data();
+    }
+    const U32 *get_repeated_letters() const
+    {
+        return repeated_letters.data();
+    }
+    void map(const array<const U32*, MAX_WORD_LENGTH> &positions, const U32 *all,
+             const U32 *repeated, size_t sz);
+    U32 match_code(const probe &guess, index_t answer) const _always_inline;
+    void match_many(const probe &guess, std::span<const index_t> answers, U32 *out_codes) const;
+    size_t filter_many(const wordle_word::match_target &mt, std::span<const index_t> candidates,
+                       index_t *out_survivors) const;
+    size_t filter_many(std::span<const target> targets, std::span<const index_t> candidates,
+                       index_t *out_survivors) const;
+private:
+    U32 match_code_repeated(const probe &guess, index_t answer) const;
+};
+
+/************************************************************************
+ * match_code - return the match_result::get_code() value for the
+ * guess played against the given answer.
+ *
+ * If the guess has no repeated letters this is simple: a letter is an
+ * exact match if it is the same as the answer's at that position, and
+ * otherwise a partial match iff the answer contains it anywhere (any
+ * other occurrence in the answer can't be an exact match, since the
+ * guess has the letter only once). So the digit is just the sum of
+ * the two tests, without branching.
+ *
+ * Guesses with repeated letters need counting, which is done out
+ * of line.
+ ***********************************************************************/
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wattributes"   // suppress warning about always_inline
+inline U32 match_view::match_code(const probe &guess, index_t answer) const
+{
+#pragma GCC diagnostic pop
+    U32 answer_letters = all_letters[answer];
+    if (!(guess.all_letters & answer_letters)) {
+        return 0;
+    }
+    if (unlikely(guess.repeated_letters)) {
+        return match_code_repeated(guess, answer);
+    }
+    U32 result = 0;
+    for (size_t i=0; i<size_t(word_length); ++i) {
+        U32 g = guess.letters[i];
+        U32 digit = U32(g==position_letters[i][answer]) + U32((g & answer_letters) != 0);
+        result += digit * powers_of_3[i];
+    }
+    return result;
+}
+
+#endif
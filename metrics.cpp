@@ -0,0 +1,107 @@
+#include "metrics.h"
+#include "formatted.h"
+
+/************************************************************************
+ * default_latency_bounds - the default latency buckets, from 100 uS
+ * to 10 S. This is a function so that metrics can be registered by
+ * static initializers in other files.
+ ***********************************************************************/
+
+const vector<float> &metrics::default_latency_bounds()
+{
+    static const vector<float> bounds = {
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+        0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10 };
+    return bounds;
+}
+
+/************************************************************************
+ * histogram constructor - one bucket per bound, plus one for +Inf
+ ***********************************************************************/
+
+metrics::histogram::histogram(const vector<float> &b)
+    : bounds(b), buckets(new std::atomic<U64>[b.size() + 1])
+{
+    std::sort(bounds.begin(), bounds.end());
+    for (size_t i : irange(0ul, bounds.size() + 1)) {
+        buckets[i] = 0;
+    }
+}
+
+/************************************************************************
+ * histogram::write - return the lines for the histogram: the cumulative
+ * count for each bucket, the sum and the count
+ ***********************************************************************/
+
+string metrics::histogram::write(const string &name, const string &labels) const
+{
+    string result;
+    string sep = labels.empty() ? "" : ",";
+    U64 count = 0;
+    for (size_t i : irange(0ul, bounds.size() + 1)) {
+        count += buckets[i].load(std::memory_order_relaxed);
+        string le = i < bounds.size() ? formatted("%g", bounds[i]) : string("+Inf");
+        result += formatted("%s_bucket{%s%sle=\"%s\"} %d\n", name, labels, sep, le, count);
+    }
+    string braces = labels.empty() ? "" : "{" + labels + "}";
+    result += formatted("%s_sum%s %.9g\n", name, braces, sum_ns.load(std::memory_order_relaxed) / 1e9);
+    result += formatted("%s_count%s %d\n", name, braces, count);
+    return result;
+}
+
+/************************************************************************
+ * add_counter, add_histogram, add_gauge, add_counter_fn - register a
+ * metric. The labels are as they are to appear between the braces,
+ * e.g. 'route="/start"'.
+ ***********************************************************************/
+
+metrics::counter &metrics::add_counter(const string &name, const string &help, const string &labels)
+{
+    counter &c = counters.emplace_back();
+    my_metrics.emplace_back(metric{ name, labels, help, counter_type, &c });
+    return c;
+}
+
+metrics::histogram &metrics::add_histogram(const string &name, const string &help, const string &labels,
+                                           const vector<float> &bounds)
+{
+    histogram &h = histograms.emplace_back(bounds);
+    my_metrics.emplace_back(metric{ name, labels, help, histogram_type, nullptr, &h });
+    return h;
+}
+
+void metrics::add_gauge(const string &name, const string &help, gauge_fn fn, const string &labels)
+{
+    my_metrics.emplace_back(metric{ name, labels, help, gauge_type, nullptr, nullptr, fn });
+}
+
+void metrics::add_counter_fn(const string &name, const string &help, gauge_fn fn, const string &labels)
+{
+    my_metrics.emplace_back(metric{ name, labels, help, counter_type, nullptr, nullptr, fn });
+}
+
+/************************************************************************
+ * write - return all the metrics in the text exposition format
+ ***********************************************************************/
+
+string metrics::write() const
+{
+    static const char *type_names[] = { "counter", "gauge", "histogram" };
+    string result;
+    const string *family = nullptr;
+    for (const metric &m : my_metrics) {
+        if (family==nullptr || *family != m.name) {
+            result += formatted("# HELP %s %s\n# TYPE %s %s\n", m.name, m.help, m.name, type_names[m.type]);
+            family = &m.name;
+        }
+        string braces = m.labels.empty() ? "" : "{" + m.labels + "}";
+        if (m.my_histogram) {
+            result += m.my_histogram->write(m.name, m.labels);
+        } else if (m.my_counter) {
+            result += formatted("%s%s %d\n", m.name, braces, m.my_counter->get());
+        } else {
+            result += formatted("%s%s %.9g\n", m.name, braces, m.fn());
+        }
+    }
+    return result;
+}
@@ -0,0 +1,106 @@
+#ifndef __METRICS
+#define __METRICS
+
+#include "types.h"
+#include <atomic>
+#include <deque>
+
+/************************************************************************
+ * metrics - a registry of counters, gauges and latency histograms,
+ * written out in the Prometheus text exposition format.
+ *
+ * All the metrics are registered at startup, before there is any
+ * concurrency, and the registry doesn't change after that. Counters and
+ * histograms are just atomics, so updating them takes no locks and they
+ * can be written by any number of threads while being read by a scrape.
+ * Gauges (and counters kept elsewhere, e.g. best_lru's hits) are read
+ * by calling a function when the metrics are written out.
+ *
+ * Metrics with the same name but different labels, e.g. the latency
+ * for each route, make up a family, which shares a HELP and TYPE line.
+ * They must be registered one after another.
+ ***********************************************************************/
+
+class metrics
+{
+public:
+    class counter
+    {
+    private:
+        std::atomic<U64> value = 0;
+    public:
+        void add(U64 n=1)
+        {
+            value.fetch_add(n, std::memory_order_relaxed);
+        }
+        U64 get() const
+        {
+            return value.load(std::memory_order_relaxed);
+        }
+    };
+    /*
+     * histogram - counts of observations in buckets with the given
+     * upper bounds (in seconds), plus one for anything larger. Only
+     * the bucket an observation falls in is counted: the cumulative
+     * counts the format wants are worked out when written.
+     */
+    class histogram
+    {
+    private:
+        vector<float> bounds;
+        unique_ptr<std::atomic<U64>[]> buckets;
+        std::atomic<U64> sum_ns = 0;
+    public:
+        histogram(const vector<float> &b);
+        void observe(float seconds)
+        {
+            size_t i = std::upper_bound(bounds.begin(), bounds.end(), seconds) - bounds.begin();
+            buckets[i].fetch_add(1, std::memory_order_relaxed);
+            sum_ns.fetch_add(U64(seconds * 1e9), std::memory_order_relaxed);
+        }
+        string write(const string &name, const string &labels) const;
+    };
+    /*
+     * timer - observe the time from construction to destruction in a
+     * histogram
+     */
+    class timer
+    {
+    private:
+        histogram &my_histogram;
+        steady_clock::time_point start;
+    public:
+        timer(histogram &h)
+            : my_histogram(h), start(steady_clock::now()) { };
+        ~timer()
+        {
+            my_histogram.observe(duration_cast<nanoseconds>(steady_clock::now() - start).count() / 1e9);
+        }
+    };
+    typedef function<double()> gauge_fn;
+    static const vector<float> &default_latency_bounds();
+private:
+    enum metric_type { counter_type, gauge_type, histogram_type };
+    struct metric
+    {
+        string name;
+        string labels;
+        string help;
+        metric_type type;
+        counter *my_counter = nullptr;
+        histogram *my_histogram = nullptr;
+        gauge_fn fn = nullptr;
+    };
+    vector<metric> my_metrics;
+    std::deque<counter> counters;
+    std::deque<histogram> histograms;
+public:
+    counter &add_counter(const string &name, const string &help, const string &labels="");
+    histogram &add_histogram(const string &name, const string &help, const string &labels="",
+                             const vector<float> &bounds=default_latency_bounds());
+    void add_gauge(const string &name, const string &help, gauge_fn fn, const string &labels="");
+    void add_counter_fn(const string &name, const string &help, gauge_fn fn, const string &labels="");
+    string write() const;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef __OBJECT_POOL
+#define __OBJECT_POOL
+
+#include "types.h"
+#include <deque>
+
+/************************************************************************
+ * object_pool - a pool of objects which are reused rather than being
+ * deleted and made again.
+ *
+ * The objects are held in a deque, so they are allocated in blocks
+ * and never move. An object which is released goes on a free list,
+ * still constructed, and acquire hands it out again before making a
+ * new one. So once the pool has grown to its working size, acquire and
+ * release don't touch the heap, and any memory the objects have
+ * allocated for themselves (e.g. the capacity of their vectors) is
+ * reused too. It is up to the caller to reset a reused object.
+ *
+ * It is not thread safe: the caller must hold a lock.
+ ***********************************************************************/
+
+template<class T>
+class object_pool
+{
+private:
+    std::deque<T> objects;
+    vector<T*> free_list;
+public:
+    /*
+     * acquire - return a free object, if there is one, with 'reused'
+     * true, else make a new one from the given constructor arguments
+     */
+    template<class... ARGS>
+    T *acquire(bool &reused, ARGS&&... args)
+    {
+        reused = !free_list.empty();
+        if (reused) {
+            T *result = free_list.back();
+            free_list.pop_back();
+            return result;
+        }
+        objects.emplace_back(std::forward<ARGS>(args)...);
+        free_list.reserve(objects.size());
+        return &objects.back();
+    }
+    void release(T *obj)
+    {
+        free_list.push_back(obj);
+    }
+    size_t size() const
+    {
+        return objects.size();
+    }
+    size_t available() const
+    {
+        return free_list.size();
+    }
+};
+
+#endif
@@ -7,15 +7,30 @@ bool do_options(int argc, char *argv[])
     od.add_options()
         ("help,h", "produce help message")
         ("allowed,a", po::value<string>()->default_value(""), "allowed words file name")
+        ("bench", "play a game for every answer, report the results and exit")
+        ("best-time", po::value<int>()->default_value(0), "time limit in mS for best in the web server (0 for none)")
+        ("cache,c", po::value<string>()->default_value(""), "file to save best word results for the first two guesses")
         ("dict,d", po::value<string>()->default_value(""), "dictionary file name")
         ("guesses,g", po::value<int>()->default_value(DEFAULT_MAX_GUESSES), "max guesses")
+        ("image,i", po::value<string>()->default_value(""), "load the dictionary from a binary image file")
+        ("incremental", "keep entropy histograms up to date as words are eliminated (needs --matrix, CLI only)")
         ("language,L", po::value<string>()->default_value(""), "language")
+        ("lookahead-time", po::value<int>()->default_value(2000), "time limit in mS for best with lookahead")
+        ("lookahead-width", po::value<int>()->default_value(10), "candidates rescored by best with lookahead")
         ("length,l", po::value<int>()->default_value(DEFAULT_WORD_LENGTH), "word length")
+        ("matrix,m", "precompute the guess/answer pattern matrix (words of up to 5 letters)")
+        ("memo,M", po::value<int>()->default_value(0), "memory limit in MB for remembering best word results (0 to disable, web server default 64)")
         ("path,p", po::value<string>()->default_value(DEFAULT_PATH), "path to language dictionaries")
         ("strict", "use strict mode")
         ("sutom,S", "play using Sutom rules")
+        ("threads,T", po::value<int>()->default_value(0), "threads to use for best (0 for one per core)")
+        ("time-sample", po::value<int>()->default_value(1), "time one in this many calls of each hot path")
+        ("tree", po::value<string>()->default_value(""), "load a decision tree file to choose best words")
+        ("tree-width", po::value<int>()->default_value(1), "candidates tried at each node when building a decision tree")
         ("verbose,V", "show details of comparison operations")
         ("vocab,v", po::value<string>()->default_value(""), "select builtin vocabulary (wordle or other)")
+        ("write-image", po::value<string>()->default_value(""), "write the dictionary to a binary image file and exit")
+        ("write-tree", po::value<string>()->default_value(""), "build a decision tree, write it to a file and exit")
         ("time,t", "show timing information");
     try {
         po::store(po::parse_command_line(argc, argv, od), options);
@@ -0,0 +1,145 @@
+#include "parallel.h"
+#include <condition_variable>
+#include <deque>
+
+namespace parallel
+{
+    /*
+     * One call of for_chunks. Pool threads join it as helpers while it
+     * is open, each taking the next worker number. Once the caller has
+     * run out of chunks it closes the job, so helpers which get to it
+     * later do nothing, and waits for those which joined to finish.
+     */
+    struct job
+    {
+        size_t count;
+        size_t threads;
+        size_t chunk;
+        const function<void(size_t, size_t, size_t)> &fn;
+        std::atomic<size_t> next = 0;
+        mutex job_mutex;
+        std::condition_variable done;
+        size_t joined = 1;
+        size_t running = 0;
+        bool closed = false;
+
+        job(size_t c, size_t t, size_t ch, const function<void(size_t, size_t, size_t)> &f)
+            : count(c), threads(t), chunk(ch), fn(f) { };
+        void work(size_t w)
+        {
+            size_t b;
+            while ((b = next.fetch_add(chunk)) < count) {
+                fn(w, b, std::min(b + chunk, count));
+            }
+        }
+        void help();
+        void finish();
+    };
+
+    /************************************************************************
+     * job::help - called on a pool thread: join the job if it is still
+     * open, and work on it until there are no chunks left
+     ***********************************************************************/
+
+    void job::help()
+    {
+        size_t w;
+        {
+            std::lock_guard<mutex> lock(job_mutex);
+            if (closed || joined >= threads) {
+                return;
+            }
+            w = joined++;
+            ++running;
+        }
+        work(w);
+        std::lock_guard<mutex> lock(job_mutex);
+        if (--running==0) {
+            done.notify_all();
+        }
+    }
+
+    /************************************************************************
+     * job::finish - called by the caller once it has no more chunks: stop
+     * any more helpers joining and wait for those that did
+     ***********************************************************************/
+
+    void job::finish()
+    {
+        std::unique_lock<mutex> lock(job_mutex);
+        closed = true;
+        done.wait(lock, [this]() { return running==0; });
+    }
+
+    /*
+     * The pool: a queue of jobs wanting helpers, with one entry per helper
+     * wanted, and the threads which take them. It is never destroyed, so
+     * the (detached) threads can't outlive it at exit.
+     */
+    class pool
+    {
+    private:
+        mutex pool_mutex;
+        std::condition_variable wanted;
+        std::deque<std::shared_ptr<job>> queue;
+        size_t thread_count = 0;
+    public:
+        void submit(const std::shared_ptr<job> &j, size_t helpers);
+    private:
+        void run();
+    };
+
+    pool *the_pool = new pool;
+
+    /************************************************************************
+     * pool::submit - ask for helpers for a job, first adding threads to
+     * the pool if there are fewer than that
+     ***********************************************************************/
+
+    void pool::submit(const std::shared_ptr<job> &j, size_t helpers)
+    {
+        std::lock_guard<mutex> lock(pool_mutex);
+        for (; thread_count < helpers; ++thread_count) {
+            std::thread(&pool::run, this).detach();
+        }
+        queue.insert(queue.end(), helpers, j);
+        wanted.notify_all();
+    }
+
+    /************************************************************************
+     * pool::run - the body of a pool thread
+     ***********************************************************************/
+
+    void pool::run()
+    {
+        while (true) {
+            std::shared_ptr<job> j;
+            {
+                std::unique_lock<mutex> lock(pool_mutex);
+                wanted.wait(lock, [this]() { return !queue.empty(); });
+                j = std::move(queue.front());
+                queue.pop_front();
+            }
+            j->help();
+        }
+    }
+
+    /************************************************************************
+     * for_chunks - see parallel.h
+     ***********************************************************************/
+
+    void for_chunks(size_t count, size_t threads, size_t chunk,
+                    const function<void(size_t, size_t, size_t)> &fn)
+    {
+        if (threads <= 1 || count <= chunk) {
+            for (size_t b = 0; b < count; b += chunk) {
+                fn(0, b, std::min(b + chunk, count));
+            }
+            return;
+        }
+        auto j = std::make_shared<job>(count, threads, chunk, fn);
+        the_pool->submit(j, threads - 1);
+        j->work(0);
+        j->finish();
+    }
+};
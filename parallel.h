@@ -0,0 +1,45 @@
+#ifndef __PARALLEL
+#define __PARALLEL
+
+#include "types.h"
+#include <thread>
+#include <atomic>
+
+/************************************************************************
+ * parallel - helpers for spreading independent work across threads.
+ ***********************************************************************/
+
+namespace parallel
+{
+    /************************************************************************
+     * thread_count - the number of threads to use for 'work' items,
+     * given the max_threads setting (0 means one per core). Never
+     * more threads than items.
+     ***********************************************************************/
+
+    inline size_t thread_count(size_t work, int requested=max_threads)
+    {
+        size_t result = requested > 0 ? requested : std::thread::hardware_concurrency();
+        return std::max(1ul, std::min(result, work));
+    }
+
+    /************************************************************************
+     * for_chunks - call fn(worker, begin, end) for consecutive chunks of
+     * [0, count) on up to 'threads' threads, the calling thread being
+     * worker 0. Chunks are handed out from a shared counter, so a thread
+     * that gets cheap chunks simply takes more of them.
+     *
+     * The other workers come from a pool of threads which is shared by
+     * all callers and made once, rather than threads being made for each
+     * call. The pool only grows to the largest number of threads asked
+     * for, less one for the caller, so however many threads call
+     * for_chunks at once (e.g. the web server's), no more than that many
+     * pool threads are working for them. If the pool is busy the caller
+     * just gets through more of the chunks itself.
+     ***********************************************************************/
+
+    void for_chunks(size_t count, size_t threads, size_t chunk,
+                    const function<void(size_t, size_t, size_t)> &fn);
+};
+
+#endif
@@ -54,6 +54,19 @@ public:
     const_iterator end() const { return entries.end(); };
     size_t size() const { return entries.size(); };
     VALUE get_worst_key() const { return worst_key; };
+    /*
+     * get_bound - the value a new entry has to beat to get into the
+     * list: the worst value held once the list is full, else the
+     * lowest (highest if increasing) possible value.
+     */
+    VALUE get_bound()
+    {
+        if (entries.size() < max_size) {
+            return decreasing ? -FLT_MAX : FLT_MAX;
+        }
+        reorder();
+        return worst_key;
+    }
     void insert(const KEY &k, const VALUE &v)
     {
         if (entries.size() < max_size) {
@@ -107,16 +120,17 @@ private:
     void reorder()
     {
         if (!sorted) {
+            auto middle = entries.begin() + std::min(max_size, entries.size());
             if (decreasing) {
-                std::partial_sort(entries.begin(), entries.begin() + max_size, entries.end(),
+                std::partial_sort(entries.begin(), middle, entries.end(),
                                   [](const entry &e1, const entry &e2){ return e2 < e1; });
             } else {
-                std::partial_sort(entries.begin(), entries.begin() + max_size, entries.end());
+                std::partial_sort(entries.begin(), middle, entries.end());
             }
             if (entries.size() > max_size) {
                 entries.resize(max_size);
             }
-            worst_key = entries.back().value;
+            worst_key = entries.empty() ? FLT_MAX : entries.back().value;
             sorted = true;
         }
     }
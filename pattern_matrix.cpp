@@ -0,0 +1,40 @@
+#include "pattern_matrix.h"
+#include "dictionary.h"
+#include <numeric>
+
+/************************************************************************
+ * usable - return true iff match codes for the current word length
+ * fit in a code_t
+ ***********************************************************************/
+
+bool pattern_matrix::usable()
+{
+    return wordle_word::match_result::code_count() <= (1u << (8 * sizeof(code_t)));
+}
+
+/************************************************************************
+ * build - compute the match code for every guess/answer pair in the
+ * dictionary. Return false (leaving the matrix empty) if the word
+ * length is too great for the codes to fit.
+ ***********************************************************************/
+
+bool pattern_matrix::build(const dictionary &dict)
+{
+    clear();
+    if (!usable() || dict.size()==0) {
+        return false;
+    }
+    size_t sz = dict.size();
+    codes.resize(sz * sz);
+    const match_view &view = dict.get_view();
+    vector<match_view::index_t> answers(sz);
+    std::iota(answers.begin(), answers.end(), 0);
+    vector<U32> row_codes(sz);
+    for (size_t g : irange(0ul, sz)) {
+        code_t *r = codes.mutable_data() + g * sz;
+        view.match_many(match_view::probe(view, g), answers, row_codes.data());
+        std::copy(row_codes.begin(), row_codes.end(), r);
+    }
+    my_size = sz;
+    return true;
+}
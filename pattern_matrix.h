@@ -0,0 +1,63 @@
+#ifndef __PATTERN_MATRIX
+#define __PATTERN_MATRIX
+
+#include "types.h"
+#include "mapped_array.h"
+
+class dictionary;
+
+/************************************************************************
+ * pattern_matrix - the match_result code (see match_result::get_code)
+ * of every dictionary word played as a guess against every dictionary
+ * word as the answer, one byte per pair.
+ *
+ * Building it costs one match per pair, once, after which entropy and
+ * filtering for dictionary words are table lookups. It is only
+ * available when the 3^N codes fit in a byte, i.e. for words of up
+ * to 5 letters.
+ ***********************************************************************/
+
+class pattern_matrix
+{
+public:
+    typedef U8 code_t;
+    typedef U32 index_t;
+private:
+    mapped_array<code_t> codes;
+    size_t my_size = 0;
+public:
+    bool valid() const
+    {
+        return my_size > 0;
+    }
+    size_t size() const
+    {
+        return my_size;
+    }
+    const code_t *row(index_t guess) const
+    {
+        return &codes[size_t(guess) * my_size];
+    }
+    code_t get(index_t guess, index_t answer) const
+    {
+        return row(guess)[answer];
+    }
+    bool build(const dictionary &dict);
+    const code_t *data() const
+    {
+        return codes.data();
+    }
+    void map(const code_t *c, size_t sz)
+    {
+        codes.map(c, sz * sz);
+        my_size = sz;
+    }
+    void clear()
+    {
+        codes.clear();
+        my_size = 0;
+    }
+    static bool usable();
+};
+
+#endif
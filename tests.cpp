@@ -7,6 +7,7 @@
 #include "entropy.h"
 #include "commands.h"
 #include "cwordle.h"
+#include <numeric>
 
 void tests::do_test(int t)
 {
@@ -23,6 +24,24 @@ void tests::do_test(int t)
     case 4:
         test4();
         break;
+    case 5:
+        test5();
+        break;
+    case 6:
+        test6();
+        break;
+    case 7:
+        test7();
+        break;
+    case 8:
+        test8();
+        break;
+    case 9:
+        test9();
+        break;
+    case 10:
+        test10();
+        break;
     default:
         break;
     }
@@ -128,30 +147,57 @@ void tests::test1()
               { "pepwq", "peeps", "peres", "pelpp" }) << '\n';
     cout << t("water", "abode", "10001", {}, {}) << "\n";
     cout << t("abode", "water", "01010", {}, {}) << "\n";
+    int saved_length = word_length;
+    word_length = 7;
+    cout << t("aaaabbb", "bbbbaaa", "1110111",
+              { "aaaabbb" },
+              { "bbbbaaa" }) << '\n';
+    word_length = saved_length;
 }
 
+/************************************************************************
+ * Check that the entropy implementations agree: the three float
+ * versions, and the integer version with its c*log(c) table.
+ ***********************************************************************/
+
 void tests::test2()
 {
+    auto check = [](const vector<float> &d) {
+        vector<U32> counts;
+        for (float f : d) {
+            if (f > 0) {
+                counts.push_back(U32(f));
+            }
+        }
+        float e[] = { entropy_slowest(d), entropy_slow(d), entropy(d), entropy(counts) };
+        bool agree = true;
+        for (float x : e) {
+            agree = agree && fabs(x - e[0]) <= 1e-4 * std::max(1.0f, fabs(e[0]));
+        }
+        cout << styled_text(formatted("%f %f %f %f", e[0], e[1], e[2], e[3]),
+                            agree ? styled_text::green : styled_text::red) << "\n";
+    };
+    entropy_table_init(100);
     vector<float> d1;
     for (size_t i : irange(0,16)) {
         d1.push_back(4);
     }
-    cout << entropy_slowest(d1) << " " << entropy_slow(d1) << " " << entropy(d1) << "\n";
+    check(d1);
     d1[1] = 10;
-    cout << entropy_slowest(d1) << " " << entropy_slow(d1) << " " << entropy(d1) << "\n";
+    check(d1);
     d1[1] = 100;
-    cout << entropy_slowest(d1) << " " << entropy_slow(d1) << " " << entropy(d1) << "\n";
+    check(d1);
     d1[1] = 1000;
-    cout << entropy_slowest(d1) << " " << entropy_slow(d1) << " " << entropy(d1) << "\n";
+    check(d1);
     d1[1] = 4;
     for (size_t i : irange(0,8)) {
         d1[i*2] = 0;
     }
-    cout << entropy_slowest(d1) << " " << entropy_slow(d1) << " " << entropy(d1) << "\n";
+    check(d1);
     for (size_t i : irange(0,16)) {
         d1[i] = i;
     }
-    cout << entropy_slowest(d1) << " " << entropy_slow(d1) << " " << entropy(d1) << "\n";
+    check(d1);
 }
 
 /************************************************************************
@@ -197,3 +243,281 @@ void tests::test4()
     }
 }
 
+
+/************************************************************************
+ * Check that match_view (both match_code and match_many) gives the same
+ * match codes as wordle_word::match for (a sample of) every pair of
+ * dictionary words, and compare their speed
+ ***********************************************************************/
+
+void tests::test5()
+{
+    const dictionary &dict = the_wordle->get_dictionary();
+    const match_view &view = dict.get_view();
+    const size_t stride = 7;
+    size_t count = 0;
+    size_t bad = 0;
+    U32 total1 = 0;
+    U32 total2 = 0;
+    U32 total3 = 0;
+    timing_reporter tr1;
+    for (size_t g = 0; g < dict.size(); g += stride) {
+        for (size_t a : irange(0ul, dict.size())) {
+            total1 += dict[g].match(dict[a]).get_code();
+        }
+    }
+    cout << tr1.report(dict.size() * ((dict.size() + stride - 1) / stride), "matches", "wordle_word::match: ");
+    timing_reporter tr2;
+    for (size_t g = 0; g < dict.size(); g += stride) {
+        match_view::probe p(view, g);
+        for (size_t a : irange(0ul, dict.size())) {
+            total2 += view.match_code(p, a);
+        }
+    }
+    cout << tr2.report(dict.size() * ((dict.size() + stride - 1) / stride), "matches", "match_view::match_code: ");
+    vector<match_view::index_t> answers(dict.size());
+    std::iota(answers.begin(), answers.end(), 0);
+    vector<U32> codes(dict.size());
+    timing_reporter tr3;
+    for (size_t g = 0; g < dict.size(); g += stride) {
+        view.match_many(match_view::probe(view, g), answers, codes.data());
+        total3 += std::accumulate(codes.begin(), codes.end(), 0u);
+    }
+    cout << tr3.report(dict.size() * ((dict.size() + stride - 1) / stride), "matches", "match_view::match_many: ");
+    for (size_t g = 0; g < dict.size(); g += stride) {
+        match_view::probe p(view, g);
+        view.match_many(p, answers, codes.data());
+        for (size_t a : irange(0ul, dict.size())) {
+            U32 c = view.match_code(p, a);
+            if (c != dict[g].match(dict[a]).get_code() || c != codes[a]) {
+                if (bad < 10) {
+                    cout << formatted("Mismatch for '%s' against '%s': %s should be %s\n",
+                                      dict[g].str(), dict[a].str(),
+                                      wordle_word::match_result::from_code(c).str(),
+                                      dict[g].match(dict[a]).str());
+                }
+                ++bad;
+            }
+            ++count;
+        }
+    }
+    cout << styled_text(formatted("%d mismatches in %d matches", bad, count),
+                        bad ? styled_text::red : styled_text::green) << "\n";
+    if (total1 != total2 || total1 != total3) {
+        cout << "Checksum error\n";
+    }
+}
+
+/************************************************************************
+ * Check that match_view::filter_many picks the same words as
+ * match_target::conforms, for match targets made from a sample of
+ * pairs of dictionary words
+ ***********************************************************************/
+
+void tests::test6()
+{
+    const dictionary &dict = the_wordle->get_dictionary();
+    const match_view &view = dict.get_view();
+    const size_t stride = 97;
+    vector<match_view::index_t> all(dict.size());
+    std::iota(all.begin(), all.end(), 0);
+    vector<match_view::index_t> survivors(dict.size());
+    size_t targets = 0;
+    size_t bad = 0;
+    for (size_t g = 0; g < dict.size(); g += stride) {
+        for (size_t a = g % 13; a < dict.size(); a += stride) {
+            wordle_word::match_target mt(dict[g], dict[g].match(dict[a]));
+            size_t n = view.filter_many(mt, all, survivors.data());
+            vector<match_view::index_t> expected;
+            for (size_t i : irange(0ul, dict.size())) {
+                if (mt.conforms(dict[i])) {
+                    expected.push_back(i);
+                }
+            }
+            if (expected != vector<match_view::index_t>(survivors.begin(), survivors.begin() + n)) {
+                if (bad < 10) {
+                    cout << formatted("Mismatch for '%s' with result %s: %d words should be %d\n",
+                                      dict[g].str(), mt.get_result().str(), n, expected.size());
+                }
+                ++bad;
+            }
+            ++targets;
+        }
+    }
+    cout << styled_text(formatted("%d mismatches in %d match targets", bad, targets),
+                        bad ? styled_text::red : styled_text::green) << "\n";
+}
+
+/************************************************************************
+ * Check that dictionary::find gives the right index for every word,
+ * and nothing for words which aren't there, and time it
+ ***********************************************************************/
+
+void tests::test7()
+{
+    const dictionary &dict = the_wordle->get_dictionary();
+    size_t bad = 0;
+    size_t found = 0;
+    timing_reporter tr;
+    for (size_t i : irange(0ul, dict.size())) {
+        auto f = dict.find(dict[i].str());
+        if (!f || f.value() != i) {
+            ++bad;
+        }
+    }
+    cout << tr.report(dict.size(), "lookups", "dictionary::find: ");
+    for (size_t i : irange(0ul, dict.size())) {
+        string w(dict[i].str());
+        for (char &ch : w) {
+            char save = ch;
+            ch = ch=='z' ? 'a' : ch + 1;
+            auto f = dict.find(w);
+            if (f && dict[f.value()].str() != w) {
+                ++bad;
+            }
+            found += f.has_value();
+            ch = save;
+        }
+        w[0] = toupper(w[0]);
+        bad += dict.find(w).has_value();
+        bad += dict.find(w + "s").has_value();
+    }
+    cout << styled_text(formatted("%d errors in %d words, %d neighbours found", bad, dict.size(), found),
+                        bad ? styled_text::red : styled_text::green) << "\n";
+}
+
+/************************************************************************
+ * Check that undoing guesses gives the same remaining words as a game
+ * which only made the earlier guesses, and that undoing them all leaves
+ * every allowed word
+ ***********************************************************************/
+
+void tests::test8()
+{
+    dictionary &dict = the_wordle->get_dictionary();
+    const size_t stride = 131;
+    size_t games = 0;
+    size_t bad = 0;
+    for (size_t a = 0; a < dict.size(); a += stride) {
+        cwordle game(&dict);
+        cwordle reference(&dict);
+        game.set_word(dict[a].str());
+        reference.set_word(dict[a].str());
+        const wordle_word &first = dict[(a * 7) % dict.size()];
+        game.try_word(first);
+        reference.try_word(first);
+        word_list expected = reference.remaining();
+        for (size_t i : irange(1, 3)) {
+            game.try_word(dict[(a * 7 + i * 1009) % dict.size()]);
+        }
+        game.undo();
+        game.undo();
+        bad += game.remaining().to_string_vector() != expected.to_string_vector();
+        bad += game.size() != 1;
+        game.undo();
+        bad += game.remaining().size() != dict.get_allowed_bits().count();
+        ++games;
+    }
+    cout << styled_text(formatted("%d errors in %d games", bad, games),
+                        bad ? styled_text::red : styled_text::green) << "\n";
+}
+
+/************************************************************************
+ * Check that filtering by an array of compact match_view::targets
+ * keeps just the words against which each guess gives the same result
+ * as against the answer, for pairs of guesses against a sample of
+ * answers, and time it against doing the same with wordle_word::match
+ ***********************************************************************/
+
+void tests::test9()
+{
+    const dictionary &dict = the_wordle->get_dictionary();
+    const match_view &view = dict.get_view();
+    const size_t stride = 53;
+    vector<match_view::index_t> all(dict.size());
+    std::iota(all.begin(), all.end(), 0);
+    vector<match_view::index_t> survivors(dict.size());
+    timing_reporter compact_timer(true);
+    timing_reporter match_timer(true);
+    size_t bad = 0;
+    size_t count = 0;
+    for (size_t a = 0; a < dict.size(); a += stride) {
+        size_t g1 = (a * 7) % dict.size();
+        size_t g2 = (a * 7 + 1009) % dict.size();
+        auto r1 = dict[g1].match(dict[a]);
+        auto r2 = dict[g2].match(dict[a]);
+        array<match_view::target, 2> targets = {
+            match_view::target(view, g1, r1),
+            match_view::target(view, g2, r2) };
+        compact_timer.restart();
+        size_t n = view.filter_many(targets, all, survivors.data());
+        compact_timer.pause();
+        match_timer.restart();
+        vector<match_view::index_t> expected;
+        for (size_t i : irange(0ul, dict.size())) {
+            if (dict[g1].match(dict[i])==r1 && dict[g2].match(dict[i])==r2) {
+                expected.push_back(i);
+            }
+        }
+        match_timer.pause();
+        bad += expected != vector<match_view::index_t>(survivors.begin(), survivors.begin() + n);
+        ++count;
+    }
+    cout << compact_timer.report(count, "filters", "match_view::target: ");
+    cout << match_timer.report(count, "filters", "wordle_word::match: ");
+    cout << styled_text(formatted("%d mismatches in %d filters", bad, count),
+                        bad ? styled_text::red : styled_text::green) << "\n";
+}
+
+/************************************************************************
+ * Check word_bitset's set operations (and, and_not, count and
+ * for_each) against the same operations on sorted index vectors, for
+ * the word lists left by pairs of guesses against a sample of answers.
+ * The second set is also tried cut down to the first half of the
+ * dictionary, since sets of different sizes can be combined.
+ ***********************************************************************/
+
+void tests::test10()
+{
+    const dictionary &dict = the_wordle->get_dictionary();
+    const size_t stride = 211;
+    word_list all(dict);
+    size_t bad = 0;
+    size_t count = 0;
+    auto members = [](const word_bitset &b) {
+        vector<dictionary::word_index_t> result;
+        b.for_each([&](word_bitset::index_t i){ result.push_back(i); });
+        return result;
+    };
+    for (size_t a = 0; a < dict.size(); a += stride) {
+        size_t g1 = (a * 7) % dict.size();
+        size_t g2 = (a * 7 + 1009) % dict.size();
+        word_list l1 = all.filter(wordle_word::match_target(dict[g1], dict[g1].match(dict[a])));
+        word_list l2 = all.filter(wordle_word::match_target(dict[g2], dict[g2].match(dict[a])));
+        vector<dictionary::word_index_t> v1(l1.begin(), l1.end());
+        vector<dictionary::word_index_t> v2(l2.begin(), l2.end());
+        word_bitset half(dict.size() / 2);
+        vector<dictionary::word_index_t> v2_half;
+        for (dictionary::word_index_t i : v2) {
+            if (i < half.size()) {
+                half.set(i);
+                v2_half.push_back(i);
+            }
+        }
+        for (const auto &[b2, w2] : { std::pair(l2.bits(), v2), std::pair(half, v2_half) }) {
+            vector<dictionary::word_index_t> both;
+            vector<dictionary::word_index_t> only;
+            std::set_intersection(v1.begin(), v1.end(), w2.begin(), w2.end(), std::back_inserter(both));
+            std::set_difference(v1.begin(), v1.end(), w2.begin(), w2.end(), std::back_inserter(only));
+            word_bitset b_and = l1.bits() & b2;
+            word_bitset b_not = l1.bits();
+            b_not.and_not(b2);
+            bad += members(l1.bits()) != v1 || l1.bits().count() != v1.size();
+            bad += members(b_and) != both || b_and.count() != both.size();
+            bad += members(b_not) != only || b_not.count() != only.size();
+            ++count;
+        }
+    }
+    cout << styled_text(formatted("%d mismatches in %d pairs of sets", bad, count),
+                        bad ? styled_text::red : styled_text::green) << "\n";
+}
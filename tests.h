@@ -13,6 +13,11 @@ private:
     static void test3();
     static void test4();
     static void test5();
+    static void test6();
+    static void test7();
+    static void test8();
+    static void test9();
+    static void test10();
     static string t(const string &w1, const string &w2, const string &correct,
              const vector<string> &good, const vector<string> &bad);
 };
@@ -62,17 +62,25 @@ typedef signed char S8;
 class cwordle;
 class commands;
 class dictionary;
+class best_cache;
+class best_lru;
+class decision_tree;
 
 extern po::variables_map options;
 extern cwordle *the_wordle;
 extern commands *the_commands;
 extern dictionary *the_dictionary;
+extern best_cache *the_best_cache;
+extern best_lru *the_best_lru;
+extern decision_tree *the_decision_tree;
 extern int word_length;
 extern int max_guesses;
+extern int max_threads;
 extern string the_language;
 extern string the_path;
 extern bool sutom_mode;
 extern bool strict_mode;
+extern bool incremental_entropy;
 extern string wordle_words;
 extern string allowed_words;
 
@@ -98,4 +106,20 @@ concept IntegralType = requires(T param)
     requires std::is_integral_v<T>;
 };
 
+/************************************************************************
+ * fnv_hash - FNV-1a hash of some bytes, continuing from a previous
+ * hash if one is given
+ ***********************************************************************/
+
+const U64 fnv_basis = 0xcbf29ce484222325ull;
+
+inline U64 fnv_hash(const void *data, size_t length, U64 h=fnv_basis)
+{
+    const U8 *p = static_cast<const U8*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        h = (h ^ p[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
 #endif
@@ -5,12 +5,19 @@
 #include "json.hpp"
 #include <random>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <string>
 #include <boost/algorithm/string.hpp>
 #include <vector>
 #include <ctime>
 #include "cwordle.h"
+#include "best_cache.h"
+#include "best_lru.h"
+#include "decision_tree.h"
+#include "object_pool.h"
+#include "instrument.h"
+#include "metrics.h"
 #include "types.h"
 #include "formatted.h"
 
@@ -24,11 +31,49 @@ random_device rd;
 mt19937 gen(rd());
 uniform_int_distribution<U32> dis(0, 1<<30);
 
-unordered_map<U32, game_info*> games;
 std::set<game_info*> old_games;
-mutex games_mutex;
+mutex pool_mutex;                       // for game_pool, old_games and gen
 
-time_t last_purge = time(nullptr);
+const int default_memo = 64;            // MB for the best result memo, unless --memo is given
+
+/************************************************************************
+ * The metrics served by /metrics. Those which are read from elsewhere
+ * when they are served (e.g. the number of games) are added in main.
+ ***********************************************************************/
+
+metrics the_metrics;
+
+struct server_metrics
+{
+    const string latency_name = "cwordle_request_duration_seconds";
+    const string latency_help = "Time taken to handle a request";
+    metrics::histogram &start_time = the_metrics.add_histogram(latency_name, latency_help, "route=\"/start\"");
+    metrics::histogram &guess_time = the_metrics.add_histogram(latency_name, latency_help, "route=\"/guess\"");
+    metrics::histogram &explore_time = the_metrics.add_histogram(latency_name, latency_help, "route=\"/explore\"");
+    metrics::histogram &best_time = the_metrics.add_histogram(latency_name, latency_help, "route=\"/best\"");
+    metrics::histogram &status_time = the_metrics.add_histogram(latency_name, latency_help, "route=\"/status\"");
+    metrics::histogram &reveal_time = the_metrics.add_histogram(latency_name, latency_help, "route=\"/reveal\"");
+    metrics::counter &best_calls = the_metrics.add_counter("cwordle_best_total",
+                                                           "Calls to best", "mode=\"best\"");
+    metrics::counter &lookahead_calls = the_metrics.add_counter("cwordle_best_total",
+                                                                "Calls to best", "mode=\"lookahead\"");
+    metrics::counter &best_incomplete = the_metrics.add_counter("cwordle_best_incomplete_total",
+                                                                "Calls to best which ran out of time");
+    metrics::histogram &best_eval_time = the_metrics.add_histogram("cwordle_best_duration_seconds",
+                                                                   "Time taken by best", "mode=\"best\"");
+    metrics::histogram &lookahead_eval_time = the_metrics.add_histogram("cwordle_best_duration_seconds",
+                                                                        "Time taken by best", "mode=\"lookahead\"");
+    metrics::counter &games_started = the_metrics.add_counter("cwordle_games_started_total", "Games started");
+    metrics::counter &purges = the_metrics.add_counter("cwordle_purges_total", "Purges of old games");
+    metrics::counter &games_purged = the_metrics.add_counter("cwordle_games_purged_total",
+                                                             "Games removed by purges");
+    metrics::counter &games_recycled = the_metrics.add_counter("cwordle_games_recycled_total",
+                                                               "Purged games returned to the pool");
+    metrics::histogram &purge_time = the_metrics.add_histogram("cwordle_purge_duration_seconds",
+                                                               "Time taken by purges");
+};
+
+server_metrics server_stats;
 
 class RequestException : public std::exception
 {
@@ -43,17 +88,29 @@ public:
     }
 };
 
+/************************************************************************
+ * game_info - a game and its housekeeping. These are kept in a pool
+ * (game_pool) and reused, so that starting a game doesn't usually
+ * allocate anything.
+ ***********************************************************************/
+
 struct game_info
 {
-    U32 id;
-    cwordle *game;
+    U32 id = 0;
+    cwordle game;
     time_t timestamp;
     mutex my_mutex;
+    bool in_play = false;
 
-    game_info(cwordle *g)
-        : id(dis(gen)), game(g), timestamp(time(nullptr))
+    game_info(dictionary *dict)
+        : game(dict), timestamp(time(nullptr))
     {        
     }
+    void reset()
+    {
+        game.reset();
+        set_timestamp();
+    }
     void set_timestamp()
     {
         timestamp = time(nullptr);
@@ -64,6 +121,132 @@ struct game_info
     }
 };
 
+object_pool<game_info> game_pool;
+
+/************************************************************************
+ * game_table - the games in play, by id.
+ *
+ * The table is split into shards by id, each with its own lock, so
+ * requests for different games rarely wait for each other, and a purge
+ * only holds up one shard at a time.
+ *
+ * A shard's lock is only held while looking in its map, not while
+ * waiting for the game's own lock, which may be held for a long time
+ * by a slow request. Since game_info objects are never freed, the
+ * pointer stays good, but the game may have been purged (and even
+ * reused) by the time its lock is taken. So once it has the lock,
+ * find_and_lock checks that the game is still in play with the same
+ * id, and only then touches its timestamp. Purging takes the game's
+ * lock before deciding whether it has expired and removing it, and
+ * /start takes it while resetting a reused game, which makes the check
+ * safe.
+ ***********************************************************************/
+
+class game_table
+{
+private:
+    static const size_t shard_count = 16;
+    struct shard
+    {
+        mutex my_mutex;
+        unordered_map<U32, game_info*> games;
+    };
+    array<shard, shard_count> shards;
+    std::atomic<size_t> count = 0;
+public:
+    /*
+     * insert - add a game, unless there is already one in play with
+     * the same id, in which case return false
+     */
+    bool insert(game_info *gi)
+    {
+        shard &sh = get_shard(gi->id);
+        lock_guard<mutex> lock(sh.my_mutex);
+        if (!sh.games.try_emplace(gi->id, gi).second) {
+            return false;
+        }
+        ++count;
+        return true;
+    }
+    game_info *find_and_lock(U32 id)
+    {
+        game_info *gi = NULL;
+        {
+            shard &sh = get_shard(id);
+            lock_guard<mutex> lock(sh.my_mutex);
+            auto it = sh.games.find(id);
+            if (it == sh.games.end()) {
+                return NULL;
+            }
+            gi = it->second;
+        }
+        gi->my_mutex.lock();
+        if (!gi->in_play || gi->id != id) {
+            gi->my_mutex.unlock();
+            return NULL;
+        }
+        gi->set_timestamp();
+        return gi;
+    }
+    /*
+     * purge_shard - remove the games in the shard for which 'expired'
+     * is true, and return them. A game whose lock can't be taken is in
+     * use, so it is left alone. 'expired' is only called with the
+     * game's lock held, and the lock is released once the game is out
+     * of play.
+     */
+    vector<game_info*> purge_shard(size_t s, const function<bool(const game_info*)> &expired)
+    {
+        vector<game_info*> result;
+        shard &sh = shards[s];
+        lock_guard<mutex> lock(sh.my_mutex);
+        for (auto it = sh.games.begin(); it != sh.games.end(); ) {
+            game_info *gi = it->second;
+            if (!gi->my_mutex.try_lock()) {
+                ++it;
+                continue;
+            }
+            if (expired(gi)) {
+                gi->in_play = false;
+                result.push_back(gi);
+                it = sh.games.erase(it);
+                --count;
+            } else {
+                ++it;
+            }
+            gi->my_mutex.unlock();
+        }
+        return result;
+    }
+    size_t size() const
+    {
+        return count;
+    }
+    static size_t get_shard_count()
+    {
+        return shard_count;
+    }
+private:
+    shard &get_shard(U32 id)
+    {
+        return shards[id % shard_count];
+    }
+};
+
+game_table games;
+
+/************************************************************************
+ * new_game_id - return a random id for a new game. The generator is
+ * shared by all the request threads, so it is only used under
+ * pool_mutex.
+ ***********************************************************************/
+
+U32 new_game_id()
+{
+    lock_guard<mutex> lock(pool_mutex);
+    return dis(gen);
+}
+
 struct request_info
 {
     json body;
@@ -106,17 +289,11 @@ struct request_info
             } catch (...) {
                 throw RequestException("No such game");
             }
-            lock_guard<mutex> lock(games_mutex);
-            auto it = games.find(game_id_n);
-            if (it == games.end()) {
-                if (game_required) {
-                    throw RequestException("No such game");
-                }
-            } else {
-                my_game_info = it->second;
-                my_game_info->set_timestamp();
-                game = my_game_info->game;
-                my_game_info->my_mutex.lock();
+            my_game_info = games.find_and_lock(game_id_n);
+            if (my_game_info) {
+                game = &my_game_info->game;
+            } else if (game_required) {
+                throw RequestException("No such game");
             }
         }
     }
@@ -147,8 +324,14 @@ void send_error_response(Http::ResponseWriter &response, const string &err)
 }
 
 /************************************************************************
- * purge_games - called periodically to get rid of completed or abandoned games
- * and very old games
+ * purge_games - get rid of completed or abandoned games and very old
+ * games, one shard of the game table at a time. They are kept out of
+ * play for a while, then returned to game_pool for reuse. They aren't
+ * kept locked: a request which found one just before it was purged
+ * sees that it is no longer in play once it gets the lock.
+ *
+ * reap_games - run purge_games periodically, in its own thread, so
+ * that no request has to wait for it.
  ***********************************************************************/
 
 const int purge_delay_over = 1*60;  // seconds
@@ -159,52 +342,124 @@ const int purge_delete_wait = 10; // seconds
 
 void purge_games()
 {
-    if (time(nullptr) - last_purge > min_purge_interval) {
-        last_purge = time(nullptr);
-        vector<game_info*> to_erase;
-        lock_guard<mutex> lock(games_mutex);
-    
-        for (auto it : games) {
-            auto *gi = it.second;
-            if ((gi->game->is_abandoned() && gi->age() > purge_delay_abandoned)
-                || (gi->game->is_over() && gi->age() > purge_delay_over)
-                || gi->age() > purge_delay_active) {
-                if (gi->my_mutex.try_lock()) {
-                    to_erase.push_back(gi);
-                }
-            }
-        }
-        for (auto gi : to_erase) {
-            // std::cout << "purge: erasing game " << gi->id << "\n";
-            games.erase(gi->id);
-            gi->set_timestamp();
-            old_games.insert(gi);
-        }
-        vector<game_info*> to_delete;
-        for (auto it : old_games) {
-            if (it->age() > purge_delete_wait) {
-                to_delete.push_back(it);
+    server_stats.purges.add();
+    metrics::timer t(server_stats.purge_time);
+    auto expired = [](const game_info *gi) {
+        return (gi->game.is_abandoned() && gi->age() > purge_delay_abandoned)
+            || (gi->game.is_over() && gi->age() > purge_delay_over)
+            || gi->age() > purge_delay_active;
+    };
+    for (size_t s : irange(0ul, game_table::get_shard_count())) {
+        auto to_erase = games.purge_shard(s, expired);
+        if (!to_erase.empty()) {
+            lock_guard<mutex> lock(pool_mutex);
+            for (auto gi : to_erase) {
+                gi->set_timestamp();
+                old_games.insert(gi);
             }
+            server_stats.games_purged.add(to_erase.size());
         }
-        for (auto gi : to_delete) {
-            // std::cout << "purge: deleting game " << gi->id << "\n";
-            old_games.erase(gi);
-            delete gi->game;
-            gi->my_mutex.unlock();
-            delete gi;
+    }
+    lock_guard<mutex> lock(pool_mutex);
+    vector<game_info*> to_delete;
+    for (auto it : old_games) {
+        if (it->age() > purge_delete_wait) {
+            to_delete.push_back(it);
         }
     }
+    for (auto gi : to_delete) {
+        old_games.erase(gi);
+        game_pool.release(gi);
+    }
+    server_stats.games_recycled.add(to_delete.size());
+}
+
+void reap_games()
+{
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(min_purge_interval));
+        purge_games();
+    }
 }
 
 /************************************************************************
  * main processing loop with rest endpoints
  ***********************************************************************/
 
-int main() {
+int main(int argc, char *argv[]) {
     Rest::Router router;
-    const char* argv[] = {"cwordle"};
-    do_options(1, (char**)argv);
-    dictionary::init();
+    if (!do_options(argc, argv)) {
+        return 1;
+    }
+    max_threads = options["threads"].as<int>();
+    if (options.count("incremental")) {
+        // each game would keep its own tracker, of 3^N counts for every word
+        cout << "--incremental is not supported by the web server\n";
+        return 1;
+    }
+    instrument::set_sample_rate(options["time-sample"].as<int>());
+    string image = options["image"].as<string>();
+    if (image.empty()) {
+        dictionary::init();
+    } else {
+        the_dictionary = new dictionary();
+        if (!the_dictionary->load_image(image)) {
+            cout << formatted("Failed to load dictionary image '%s'\n", image);
+            return 1;
+        }
+    }
+    if (options.count("matrix") > 0 && !the_dictionary->get_matrix().valid()) {
+        the_dictionary->build_matrix();
+    }
+    string tree_file = options["tree"].as<string>();
+    if (!tree_file.empty()) {
+        the_decision_tree = new decision_tree(*the_dictionary);
+        if (!the_decision_tree->load(tree_file)) {
+            cout << formatted("Failed to load decision tree '%s'\n", tree_file);
+            return 1;
+        }
+    }
+    string cache_file = options["cache"].as<string>();
+    if (!cache_file.empty()) {
+        the_best_cache = new best_cache(*the_dictionary);
+        if (!the_best_cache->open(cache_file)) {
+            cout << formatted("Failed to open cache file '%s'\n", cache_file);
+            return 1;
+        }
+        if (!the_best_cache->has_openers()) {
+            cwordle(the_dictionary).best(best_cache::opener_count);
+        }
+    }
+    int memo = options["memo"].defaulted() ? default_memo : options["memo"].as<int>();
+    if (memo > 0) {
+        the_best_lru = new best_lru(*the_dictionary, size_t(memo) << 20);
+    }
+    the_metrics.add_gauge("cwordle_games_active", "Games in play",
+                          [](){ return games.size(); });
+    the_metrics.add_gauge("cwordle_games_pooled", "Games held in the pool, in play or not",
+                          [](){ lock_guard<mutex> lock(pool_mutex); return game_pool.size(); });
+    the_metrics.add_gauge("cwordle_games_free", "Games in the pool ready for reuse",
+                          [](){ lock_guard<mutex> lock(pool_mutex); return game_pool.available(); });
+    the_metrics.add_counter_fn("cwordle_memo_hits_total", "Best results found in the memo",
+                               [](){ return the_best_lru ? the_best_lru->get_stats().hits : 0; });
+    the_metrics.add_counter_fn("cwordle_memo_misses_total", "Best results not found in the memo",
+                               [](){ return the_best_lru ? the_best_lru->get_stats().misses : 0; });
+    the_metrics.add_gauge("cwordle_memo_entries", "Best results held in the memo",
+                          [](){ return the_best_lru ? the_best_lru->get_stats().entries : 0; });
+    the_metrics.add_gauge("cwordle_cache_entries", "Best results held in the cache file",
+                          [](){ return the_best_cache ? the_best_cache->size() : 0; });
+    for (size_t c : irange(0, int(instrument::counter_count))) {
+        auto ctr = instrument::counter(c);
+        string labels = formatted("path=\"%s\"", instrument::name(ctr));
+        the_metrics.add_counter_fn("cwordle_hot_path_calls_total", "Calls to each hot path",
+                                   [ctr](){ return instrument::collect()[ctr].calls; }, labels);
+    }
+    for (size_t c : irange(0, int(instrument::counter_count))) {
+        auto ctr = instrument::counter(c);
+        string labels = formatted("path=\"%s\"", instrument::name(ctr));
+        the_metrics.add_counter_fn("cwordle_hot_path_seconds_total", "Time spent in each hot path",
+                                   [ctr](){ return instrument::collect()[ctr].ns / 1e9; }, labels);
+    }
 
     /************************************************************************
      * Handle /start endpoint
@@ -212,21 +467,32 @@ int main() {
         
     router.post("/start", [&](const Rest::Request& req, Http::ResponseWriter response)
     {
-        purge_games();
+        metrics::timer t(server_stats.start_time);
         request_info ri;
         ri.build(req, {}, false);
         if (ri.game) {
             ri.game->abandon();
         }
-        cwordle *new_game = NULL;
         game_info *gi = NULL;
+        bool reused = false;
+        {
+            lock_guard<mutex> lock(pool_mutex);
+            gi = game_pool.acquire(reused, the_dictionary);
+        }
         {
-            lock_guard<mutex> lock(games_mutex);
-            new_game = new cwordle(the_dictionary);
-            gi = new game_info(new_game);
-            games[gi->id] = gi;
+            lock_guard<mutex> lock(gi->my_mutex);
+            if (reused) {
+                gi->reset();
+            }
+            gi->id = new_game_id();
+            gi->game.new_word();
+            gi->in_play = true;
         }
-        new_game->new_word();
+        while (!games.insert(gi)) {
+            lock_guard<mutex> lock(gi->my_mutex);
+            gi->id = new_game_id();
+        }
+        server_stats.games_started.add();
         json res = { {"game_id", lexical_cast<string>(gi->id)}, {"length", word_length} };
         send_good_response(response, res);
         return Rest::Route::Result::Ok;
@@ -238,6 +504,7 @@ int main() {
     
     router.post("/reveal", [&](const Rest::Request& req, Http::ResponseWriter response)
     {
+        metrics::timer t(server_stats.reveal_time);
         try {
             request_info ri;
             ri.build(req, {});
@@ -256,6 +523,7 @@ int main() {
 
     router.post("/guess", [&](const Rest::Request& req, Http::ResponseWriter response)
     {
+        metrics::timer t(server_stats.guess_time);
         try {
             request_info ri;
             ri.build(req, {"guess"});
@@ -300,6 +568,7 @@ int main() {
         
     router.post("/explore", [&](const Rest::Request& req, Http::ResponseWriter response)
     {
+        metrics::timer t(server_stats.explore_time);
         try {
             request_info ri;
             ri.build(req, {"guess", "explore_state"});
@@ -339,22 +608,40 @@ int main() {
     });
 
     /************************************************************************
-     * Handle /best endpoint
+     * Handle /best endpoint. If "lookahead" is true, look two guesses
+     * ahead, within "budget" mS if given, but never more than the
+     * --lookahead-time option. Otherwise, stop after "budget" mS if
+     * given, or the --best-time option if that is less. "complete"
+     * says whether all the words were tried in time. Before the first
+     * guess the answer comes from the best cache, if there is one.
      ***********************************************************************/
     
     router.post("/best", [&](const Rest::Request& req, Http::ResponseWriter response)
     {
+        metrics::timer t(server_stats.best_time);
         try {
             request_info ri;
             ri.build(req, {});
             std::vector<std::string> words;
-            if (!(ri.game->is_over() || ri.game->size()==0)) {            
-                auto best_list = ri.game->best(5);
+            bool complete = true;
+            if (!ri.game->is_over()) {
+                bool lookahead = ri.body.count("lookahead") && ri.body["lookahead"].get<bool>();
+                int limit = options[lookahead ? "lookahead-time" : "best-time"].as<int>();
+                int budget = ri.body.count("budget") ? ri.body["budget"].get<int>() : limit;
+                if (limit > 0) {
+                    budget = budget > 0 ? std::min(budget, limit) : limit;
+                }
+                (lookahead ? server_stats.lookahead_calls : server_stats.best_calls).add();
+                metrics::timer bt(lookahead ? server_stats.lookahead_eval_time : server_stats.best_eval_time);
+                auto best_list = lookahead
+                    ? ri.game->best_lookahead(5, options["lookahead-width"].as<int>(), budget, complete)
+                    : ri.game->best(5, budget, complete);
+                server_stats.best_incomplete.add(!complete);
                 for (const auto& r : best_list) {
                     if (r.key) words.push_back(string(r.key->str()));
                 }
             }
-            json res = { {"best", words} };
+            json res = { {"best", words}, {"complete", complete} };
             send_good_response(response, res);
             return Rest::Route::Result::Ok;
         } catch (const RequestException &exc) {
@@ -364,21 +651,70 @@ int main() {
     });
         
     /************************************************************************
-     * Handle /status endpoint
+     * Handle /memo endpoint - statistics for the shared best result memo
+     ***********************************************************************/
+
+    router.get("/memo", [&](const Rest::Request& req, Http::ResponseWriter response)
+    {
+        best_lru::stats st;
+        if (the_best_lru) {
+            st = the_best_lru->get_stats();
+        }
+        json res = {
+            {"enabled", the_best_lru != NULL},
+            {"hits", st.hits},
+            {"misses", st.misses},
+            {"entries", st.entries},
+            {"memory_used", st.memory_used},
+            {"memory_limit", st.memory_limit}
+        };
+        send_good_response(response, res);
+        return Rest::Route::Result::Ok;
+    });
+
+    /************************************************************************
+     * Handle /timing endpoint - calls, words and time for each hot path
+     * since the server started, for all threads
+     ***********************************************************************/
+
+    router.get("/timing", [&](const Rest::Request& req, Http::ResponseWriter response)
+    {
+        auto totals = instrument::collect();
+        json res = { {"enabled", instrument::enabled} };
+        for (size_t c : irange(0, int(instrument::counter_count))) {
+            const auto &t = totals[instrument::counter(c)];
+            res[instrument::name(instrument::counter(c))] = {
+                {"calls", t.calls},
+                {"items", t.items},
+                {"ns", t.ns}
+            };
+        }
+        send_good_response(response, res);
+        return Rest::Route::Result::Ok;
+    });
+
+    /************************************************************************
+     * Handle /metrics endpoint - all the metrics, in Prometheus text
+     * format
+     ***********************************************************************/
+
+    router.get("/metrics", [&](const Rest::Request& req, Http::ResponseWriter response)
+    {
+        response.send(Http::Code::Ok, the_metrics.write(), MIME(Text, Plain));
+        return Rest::Route::Result::Ok;
+    });
+
+    /************************************************************************
+     * Handle /status endpoint. This doesn't call best, whose words are
+     * only given by /best, within its time limit.
      ***********************************************************************/
     
     router.get("/status", [&](const Rest::Request& req, Http::ResponseWriter response)
     {
+        metrics::timer t(server_stats.status_time);
         try {
             request_info ri;
             ri.build(req, {});
-            std::vector<std::string> words;
-            if (!(ri.game->is_over() || ri.game->size()==0)) {            
-                auto best_list = ri.game->best(5);
-                for (const auto& r : best_list) {
-                    if (r.key) words.push_back(string(r.key->str()));
-                }
-            }
             json res = {
                 {"guesses", ri.game->size()},
                 {"won", ri.game->is_won()},
@@ -413,6 +749,7 @@ int main() {
      * Main loop
      ***********************************************************************/
     
+    std::thread(reap_games).detach();
     while (true) {
         try {
             auto server = std::make_unique<Http::Endpoint>(Address(Ipv4::any(), Port(18080)));
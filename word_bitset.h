@@ -0,0 +1,237 @@
+#ifndef __WORD_BITSET
+#define __WORD_BITSET
+
+#include "types.h"
+#include <span>
+
+/************************************************************************
+ * word_bitset - a set of dictionary indices, as one bit per word.
+ *
+ * Set operations (and, and-not) work a U64 at a time, the size is a
+ * popcount, and iteration skips straight from one set bit to the next.
+ * For the English dictionary the whole set is about 1.6 KB.
+ *
+ * Bits beyond the size of the set are always zero, so sets of
+ * different sizes can be combined, the missing bits counting as zero.
+ ***********************************************************************/
+
+class word_bitset
+{
+public:
+    typedef U32 index_t;
+private:
+    vector<U64> bits;
+    size_t my_size = 0;
+public:
+    word_bitset(size_t sz=0)
+    {
+        resize(sz);
+    }
+    static word_bitset all(size_t sz)
+    {
+        word_bitset result(sz);
+        std::fill(result.bits.begin(), result.bits.end(), ~0ull);
+        result.trim();
+        return result;
+    }
+    size_t size() const
+    {
+        return my_size;
+    }
+    void resize(size_t sz)
+    {
+        my_size = sz;
+        bits.resize((sz + 63) / 64);
+        trim();
+    }
+    void set(index_t i)
+    {
+        if (i >= my_size) {
+            resize(i + 1);
+        }
+        bits[i / 64] |= 1ull << (i % 64);
+    }
+    void reset(index_t i)
+    {
+        if (i < my_size) {
+            bits[i / 64] &= ~(1ull << (i % 64));
+        }
+    }
+    bool test(index_t i) const
+    {
+        return i < my_size && (bits[i / 64] & (1ull << (i % 64))) != 0;
+    }
+    size_t count() const
+    {
+        size_t result = 0;
+        for (U64 b : bits) {
+            result += __builtin_popcountll(b);
+        }
+        return result;
+    }
+    bool empty() const
+    {
+        return std::all_of(bits.begin(), bits.end(), [](U64 b){ return b==0; });
+    }
+    word_bitset &operator&=(const word_bitset &other)
+    {
+        for (size_t i : irange(0ul, bits.size())) {
+            bits[i] &= i < other.bits.size() ? other.bits[i] : 0;
+        }
+        return *this;
+    }
+    word_bitset operator&(const word_bitset &other) const
+    {
+        word_bitset result(*this);
+        result &= other;
+        return result;
+    }
+    word_bitset &and_not(const word_bitset &other)
+    {
+        for (size_t i : irange(0ul, std::min(bits.size(), other.bits.size()))) {
+            bits[i] &= ~other.bits[i];
+        }
+        return *this;
+    }
+    bool operator==(const word_bitset &other) const
+    {
+        size_t n = std::max(bits.size(), other.bits.size());
+        for (size_t i : irange(0ul, n)) {
+            if ((i < bits.size() ? bits[i] : 0) != (i < other.bits.size() ? other.bits[i] : 0)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    /************************************************************************
+     * for_each - call fn(index) for each member, in increasing order
+     ***********************************************************************/
+    template<class FN>
+    void for_each(FN fn) const
+    {
+        for (size_t i : irange(0ul, bits.size())) {
+            U64 b = bits[i];
+            while (b) {
+                fn(index_t(i * 64 + __builtin_ctzll(b)));
+                b &= b - 1;
+            }
+        }
+    }
+    const vector<U64> &get_words() const
+    {
+        return bits;
+    }
+private:
+    void trim()
+    {
+        if (my_size % 64) {
+            bits.back() &= (1ull << (my_size % 64)) - 1;
+        }
+    }
+};
+
+/************************************************************************
+ * word_bitset_stack - a stack of sets of dictionary indices, one bit
+ * per word, held one after another in a single vector.
+ *
+ * It is used for the history of a game, one set per guess. Popping or
+ * clearing just changes the depth, and the vector keeps its capacity,
+ * so once it has grown no more memory is allocated. Each set takes
+ * size/8 bytes, however many words are in it.
+ ***********************************************************************/
+
+class word_bitset_stack
+{
+public:
+    typedef word_bitset::index_t index_t;
+private:
+    vector<U64> bits;
+    size_t set_words = 0;
+    size_t depth = 0;
+public:
+    word_bitset_stack(size_t sz=0, size_t max_depth=0)
+        : set_words((sz + 63) / 64)
+    {
+        bits.reserve(set_words * max_depth);
+    }
+    size_t size() const
+    {
+        return depth;
+    }
+    bool empty() const
+    {
+        return depth==0;
+    }
+    void clear()
+    {
+        depth = 0;
+    }
+    void pop()
+    {
+        if (depth > 0) {
+            --depth;
+        }
+    }
+    /************************************************************************
+     * push - push the set of the given indices. If any is beyond the
+     * size of the sets, e.g. because words have been added to the
+     * dictionary, every set is made larger to hold it.
+     ***********************************************************************/
+    template<class IT>
+    void push(IT b, IT e)
+    {
+        for (IT i = b; i != e; ++i) {
+            if (*i / 64 >= set_words) {
+                grow(*i / 64 + 1);
+            }
+        }
+        bits.resize((depth + 1) * set_words);
+        U64 *top = bits.data() + depth * set_words;
+        std::fill(top, top + set_words, 0);
+        for (IT i = b; i != e; ++i) {
+            top[*i / 64] |= 1ull << (*i % 64);
+        }
+        ++depth;
+    }
+    size_t count() const
+    {
+        size_t result = 0;
+        for (U64 b : top_words()) {
+            result += __builtin_popcountll(b);
+        }
+        return result;
+    }
+    /************************************************************************
+     * for_each - call fn(index) for each member of the top set, in
+     * increasing order
+     ***********************************************************************/
+    template<class FN>
+    void for_each(FN fn) const
+    {
+        std::span<const U64> top = top_words();
+        for (size_t i : irange(0ul, top.size())) {
+            U64 b = top[i];
+            while (b) {
+                fn(index_t(i * 64 + __builtin_ctzll(b)));
+                b &= b - 1;
+            }
+        }
+    }
+private:
+    std::span<const U64> top_words() const
+    {
+        return depth==0 ? std::span<const U64>() : std::span<const U64>(bits.data() + (depth - 1) * set_words, set_words);
+    }
+    void grow(size_t new_words)
+    {
+        vector<U64> grown(depth * new_words, 0);
+        for (size_t d : irange(0ul, depth)) {
+            std::copy(bits.begin() + d * set_words, bits.begin() + (d + 1) * set_words,
+                      grown.begin() + d * new_words);
+        }
+        bits = std::move(grown);
+        set_words = new_words;
+    }
+};
+
+#endif
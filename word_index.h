@@ -0,0 +1,164 @@
+#ifndef __WORD_INDEX
+#define __WORD_INDEX
+
+#include "types.h"
+#include "mapped_array.h"
+
+/************************************************************************
+ * word_index - map from a word to its dictionary index.
+ *
+ * The key is the word's letters packed 5 bits each, as 1-26, into a
+ * U128. That is enough for MAX_WORD_LENGTH letters, and since no
+ * letter packs to zero, zero is never a valid key and marks an empty
+ * slot. Anything which isn't all lower case letters has no key, and
+ * so is never found.
+ *
+ * The table is open addressing with linear probing, a power of two
+ * in size and at most half full. Keys and values are held in separate
+ * arrays so a probe sequence stays within a cache line or two.
+ *
+ * Lookup is by string_view and does not allocate.
+ *
+ * The arrays can be mapped from a dictionary image, in which case
+ * they are copied if anything is inserted.
+ ***********************************************************************/
+
+class word_index
+{
+public:
+    typedef U128 key_t;
+    typedef U32 value_t;
+private:
+    mapped_array<key_t> keys;
+    mapped_array<value_t> values;
+    size_t my_size = 0;
+    size_t mask = 0;
+public:
+    size_t size() const
+    {
+        return my_size;
+    }
+    void clear()
+    {
+        keys.clear();
+        values.clear();
+        my_size = 0;
+        mask = 0;
+    }
+    /************************************************************************
+     * make_key - pack a word into a key, or return a null value if it
+     * is too long or has anything other than lower case letters
+     ***********************************************************************/
+    static optional<key_t> make_key(const string_view &w)
+    {
+        optional<key_t> result;
+        if (!w.empty() && w.size() <= MAX_WORD_LENGTH) {
+            key_t k = 0;
+            for (char ch : w) {
+                if (ch < 'a' || ch > 'z') {
+                    return result;
+                }
+                k = (k << 5) | key_t(ch - 'a' + 1);
+            }
+            result = k;
+        }
+        return result;
+    }
+    optional<value_t> find(const string_view &w) const
+    {
+        optional<value_t> result;
+        auto k = make_key(w);
+        if (k && my_size > 0) {
+            for (size_t i = slot_of(k.value()); keys[i] != 0; i = (i + 1) & mask) {
+                if (keys[i]==k.value()) {
+                    result = values[i];
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+    /************************************************************************
+     * insert - add a word, returning false if it has no key or is
+     * already present
+     ***********************************************************************/
+    bool insert(const string_view &w, value_t value)
+    {
+        auto k = make_key(w);
+        if (!k) {
+            return false;
+        }
+        if ((my_size + 1) * 2 > keys.size()) {
+            rehash(std::max(size_t(64), keys.size() * 2));
+        }
+        size_t i = slot_of(k.value());
+        for ( ; keys[i] != 0; i = (i + 1) & mask) {
+            if (keys[i]==k.value()) {
+                return false;
+            }
+        }
+        keys.set(i, k.value());
+        values.set(i, value);
+        ++my_size;
+        return true;
+    }
+    size_t capacity() const
+    {
+        return keys.size();
+    }
+    const key_t *get_keys() const
+    {
+        return keys.data();
+    }
+    const value_t *get_values() const
+    {
+        return values.data();
+    }
+    /************************************************************************
+     * map - use arrays from a dictionary image, which must have been
+     * written from another word_index
+     ***********************************************************************/
+    void map(const key_t *k, const value_t *v, size_t capacity, size_t sz)
+    {
+        keys.map(k, capacity);
+        values.map(v, capacity);
+        mask = capacity - 1;
+        my_size = sz;
+    }
+    void reserve(size_t n)
+    {
+        size_t capacity = 64;
+        while (capacity < n * 2) {
+            capacity *= 2;
+        }
+        if (capacity > keys.size()) {
+            rehash(capacity);
+        }
+    }
+private:
+    size_t slot_of(key_t k) const
+    {
+        U64 h = U64(k) ^ U64(k >> 64);
+        return ((h * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+    }
+    void rehash(size_t capacity)
+    {
+        vector<key_t> new_keys(capacity, 0);
+        vector<value_t> new_values(capacity, 0);
+        mask = capacity - 1;
+        for (size_t j : irange(0ul, keys.size())) {
+            if (keys[j] != 0) {
+                size_t i = slot_of(keys[j]);
+                while (new_keys[i] != 0) {
+                    i = (i + 1) & mask;
+                }
+                new_keys[i] = keys[j];
+                new_values[i] = values[j];
+            }
+        }
+        keys.swap(new_keys);
+        values.swap(new_values);
+    }
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "word_list.h"
 #include "entropy.h"
-#include "timers.h"
+#include "instrument.h"
+#include <numeric>
 
 /************************************************************************
  * word_list - representation of a list of words from the dictionary.
@@ -12,40 +13,81 @@
  * The words are held as indices into the dictionary.
  ***********************************************************************/
 
+/************************************************************************
+ * Constructor from a word_bitset, taking the words in index order
+ ***********************************************************************/
+
+word_list::word_list(const dictionary &d, const word_bitset &bits)
+    : my_dict(d), unfilled(false)
+{
+    my_words.reserve(bits.count());
+    bits.for_each([&](word_bitset::index_t i){ my_words.emplace_back(i); });
+}
+
+/************************************************************************
+ * filter_scratch - return this thread's scratch vector, of at least
+ * the given size, for the filters to write the survivors to. They are
+ * then copied to the result, which is allocated once at the right
+ * size, rather than with room for every word we start from.
+ ***********************************************************************/
+
+static word_list::word_vector_t &filter_scratch(size_t size)
+{
+    thread_local word_list::word_vector_t scratch;
+    if (scratch.size() < size) {
+        scratch.resize(size);
+    }
+    return scratch;
+}
+
 /************************************************************************
  * filter - give a match_target, return a word_list containing only
  * the words from my list that also match the target.
  *
- * There are two cases, one for when the list is unfilled and one
- * for when we have an explciit list of words.
+ * The work is done in bulk by the dictionary's match_view, which
+ * writes out the survivors to the scratch vector. If the list is
+ * unfilled we start from a list of the whole dictionary, in the
+ * scratch vector itself, which is filtered in place.
+ *
+ * The time is counted once for the whole list, not per word, but the
+ * words are counted too.
  ***********************************************************************/
 
 word_list word_list::filter(const wordle_word::match_target &mt) const
 {
-    word_list result(my_dict);
+    instrument::scope timing(instrument::conforms);
+    timing.add_items(size());
+    word_vector_t &survivors = filter_scratch(my_dict.size());
+    std::span<const dictionary::word_index_t> candidates(my_words);
     if (unfilled) {
-        for (size_t i : irange(0ul, my_dict.size())) {
-            const wordle_word &w = my_dict[i];
-            timers::conforms_timer.restart();
-            bool c = mt.conforms(w);
-            timers::conforms_timer.pause();
-            if (c) {
-                result.insert(i);
-            }
-        }
-    } else {
-        result.unfilled = false;
-        for (dictionary::word_index_t i : *this) {
-            const wordle_word &w = my_dict[i];
-            timers::conforms_timer.restart();
-            bool c = mt.conforms(w);
-            timers::conforms_timer.pause();
-            if (c) {
-                result.insert(i);
-            }
+        std::iota(survivors.begin(), survivors.begin() + my_dict.size(), 0);
+        candidates = std::span(survivors.data(), my_dict.size());
+    }
+    size_t count = my_dict.get_view().filter_many(mt, candidates, survivors.data());
+    return word_list(my_dict, word_vector_t(survivors.begin(), survivors.begin() + count));
+}
+
+/************************************************************************
+ * filter - as above, but for a guess which is in the dictionary, using
+ * the dictionary's pattern_matrix. A word survives iff playing the
+ * guess against it would have given the same result. The matrix
+ * must be valid.
+ ***********************************************************************/
+
+word_list word_list::filter(dictionary::word_index_t guess, const wordle_word::match_result &mr) const
+{
+    instrument::scope timing(instrument::conforms);
+    timing.add_items(size());
+    word_vector_t &survivors = filter_scratch(size());
+    const pattern_matrix::code_t *row = my_dict.get_matrix().row(guess);
+    pattern_matrix::code_t code = mr.get_code();
+    size_t count = 0;
+    for (dictionary::word_index_t i : *this) {
+        if (row[i]==code) {
+            survivors[count++] = i;
         }
     }
-    return result;
+    return word_list(my_dict, word_vector_t(survivors.begin(), survivors.begin() + count));
 }
 
 /************************************************************************
@@ -98,6 +140,72 @@ word_list word_list::filter_pred(function<bool(const string_view &w)> pred) cons
     return result;
 }
 
+/************************************************************************
+ * partition - split the list by the result the given dictionary word
+ * would give as a guess against each of its words, returning the words
+ * for each match code. The codes come from the pattern_matrix if there
+ * is one, else from the match_view.
+ ***********************************************************************/
+
+map<U32, word_list::word_vector_t> word_list::partition(dictionary::word_index_t guess) const
+{
+    map<U32, word_vector_t> result;
+    const pattern_matrix &pm = my_dict.get_matrix();
+    const match_view &view = my_dict.get_view();
+    match_view::probe p(view, guess);
+    for (dictionary::word_index_t w : *this) {
+        result[pm.valid() ? pm.get(guess, w) : view.match_code(p, w)].push_back(w);
+    }
+    return result;
+}
+
+/************************************************************************
+ * bits - return the list as a word_bitset
+ ***********************************************************************/
+
+word_bitset word_list::bits() const
+{
+    if (unfilled) {
+        return word_bitset::all(my_dict.size());
+    }
+    word_bitset result(my_dict.size());
+    for (dictionary::word_index_t i : my_words) {
+        result.set(i);
+    }
+    return result;
+}
+
+/************************************************************************
+ * intersect - return a word_list containing the words which are in
+ * both this list and the given set. Used with the dictionary's allowed
+ * set, where an unfilled list just gives the set itself. Otherwise
+ * each of our words is looked up in the set, which costs nothing like
+ * converting the list to a bitset and back.
+ ***********************************************************************/
+
+word_list word_list::intersect(const word_bitset &other) const
+{
+    if (unfilled) {
+        return word_list(my_dict, other);
+    }
+    word_vector_t result;
+    result.reserve(my_words.size());
+    std::copy_if(my_words.begin(), my_words.end(), std::back_inserter(result),
+                 [&](dictionary::word_index_t i) { return other.test(i); });
+    return word_list(my_dict, std::move(result));
+}
+
+/************************************************************************
+ * hash - return a hash of the words in the list. An unfilled list has
+ * the same hash as the filled list of the whole dictionary.
+ ***********************************************************************/
+
+U64 word_list::hash() const
+{
+    fill();
+    return fnv_hash(my_words.data(), my_words.size() * sizeof(my_words[0]));
+}
+
 /************************************************************************
  * sorted - return a word_list in which the words have been
  * sorted into alphabetical order
@@ -141,29 +249,61 @@ void word_list::fill() const
  * Then we use the entropy() function to calculate the entropy of the
  * resulting distribition.
  *
- * There are 1024 possible values of a match result, but in fact only
- * 243 (3^5) of those are valid, since an exact match eclipses a partial
- * match of the same letter. We don't try to take advantage of that.
+ * Results are counted by their dense code (match_result::get_code),
+ * of which there are 3^N, so 243 for 5-letter words. The counting
+ * is done in a histogram, which for long words switches to a hash
+ * map rather than a mostly empty (or impossibly large) vector. Only
+ * the non-zero counts are passed to the integer entropy() kernel.
+ *
+ * The histogram is supplied by the caller, or else is the per-thread
+ * scratch histogram, so there is no allocation once it has grown to
+ * size.
+ *
+ * The codes are calculated from the dictionary's match_view, which
+ * holds just the letters of each word in compact arrays, rather than
+ * with wordle_word::match. They are calculated a block at a time by
+ * match_many, which does 16 words per AVX512 instruction. If the
+ * target is a dictionary word and the dictionary has a pattern_matrix,
+ * the codes are just looked up.
  ***********************************************************************/
 
+const size_t match_block_size = 256;
+
 float word_list::entropy(const wordle_word &target) const
 {
-    vector<float> counts;
-    counts.resize(1 << (target.size()*2));
-    std::fill(counts.begin(), counts.end(), 0.0);
-    timers::match_timer.restart();
-    int count = 0;
-    for (const auto &idx : *this) {
-        auto mr = target.match(my_dict[idx]);
-        counts[mr.get_hash()] += 1;
-        ++count;
+    return entropy(target, histogram::scratch());
+}
+
+float word_list::entropy(const wordle_word &target, histogram &counts) const
+{
+    const pattern_matrix &pm = my_dict.get_matrix();
+    auto guess = pm.valid() ? my_dict.index_of(target) : std::nullopt;
+    counts.start(wordle_word::match_result::code_count());
+    {
+        instrument::scope timing(instrument::match);
+        timing.add_items(size());
+        if (guess) {
+            const pattern_matrix::code_t *row = pm.row(guess.value());
+            for (const auto &idx : *this) {
+                counts.add(row[idx]);
+            }
+        } else {
+            const match_view &view = my_dict.get_view();
+            match_view::probe probe(target);
+            fill();
+            std::span<const dictionary::word_index_t> answers(my_words.data(), my_words.size());
+            U32 codes[match_block_size];
+            for (size_t b = 0; b < answers.size(); b += match_block_size) {
+                auto block = answers.subspan(b, std::min(match_block_size, answers.size() - b));
+                view.match_many(probe, block, codes);
+                for (size_t i : irange(0ul, block.size())) {
+                    counts.add(codes[i]);
+                }
+            }
+        }
     }
-    timers::match_timer.pause();
-    timers::match_timer.adjust_count(count ? count-1 : 0);
-    timers::entropy_timer.restart();
-    float result = ::entropy(counts);
-    timers::entropy_timer.pause();
-    return result;
+    instrument::scope timing(instrument::entropy);
+    return ::entropy(counts.values());
 }
 
 /************************************************************************
@@ -4,6 +4,14 @@
 #include "types.h"
 #include "dictionary.h"
 #include "wordle_word.h"
+#include "histogram.h"
+#include "word_bitset.h"
+
+/************************************************************************
+ * word_list - a list of dictionary words, held as a vector of indices
+ * (see word_list.cpp). It is not held as a word_bitset, but can be
+ * made from one, turned into one (bits), or intersected with one.
+ ***********************************************************************/
 
 class word_list
 {
@@ -17,7 +25,10 @@ private:
     word_vector_t my_words;
 public:
     word_list(const dictionary &d) : my_dict(d) { };
-    bool empty() const { return !unfilled || my_words.empty(); }
+    word_list(const dictionary &d, const word_bitset &bits);
+    word_list(const dictionary &d, word_vector_t &&words)
+        : my_dict(d), unfilled(false), my_words(std::move(words)) { };
+    bool empty() const { return unfilled ? my_dict.size()==0 : my_words.empty(); }
     size_t size() const { return unfilled ? my_dict.size() : my_words.size(); }
     iterator begin() { fill(); return my_words.begin(); }
     iterator end() { fill(); return my_words.end(); }
@@ -25,10 +36,16 @@ public:
     const_iterator end() const { fill(); return my_words.end(); }
     dictionary::word_index_t operator[](size_t idx) const { fill(); return my_words[idx]; }
     word_list filter(const wordle_word::match_target &mt) const;
+    word_list filter(dictionary::word_index_t guess, const wordle_word::match_result &mr) const;
     word_list filter_exact(const wordle_word::match_target &mt) const;
     word_list filter_pred(function<bool(const string_view &w)> pred) const;
+    map<U32, word_vector_t> partition(dictionary::word_index_t guess) const;
+    word_list intersect(const word_bitset &other) const;
+    word_bitset bits() const;
+    U64 hash() const;
     word_list sorted() const;
     float entropy(const wordle_word &w) const;
+    float entropy(const wordle_word &w, histogram &counts) const;
     string str(size_t length=0) const;
     vector<string> to_string_vector(size_t length=0) const;
 private:
@@ -65,6 +65,10 @@
  * Holding this information greatly speeds up the 'match' and 'conforms'
  * functions.
  *
+ * The text is held in a fixed size array, so a wordle_word is
+ * trivially copyable and a dictionary of them can be written to and
+ * used straight from a binary image (see dictionary::write_image).
+ *
  ***********************************************************************/
 
 /************************************************************************
@@ -94,8 +98,8 @@ void wordle_word::set_word_basic(const string_view &w)
     letter_mask once;
     letter_mask twice;
     letter_mask many;
-    text = w;
-    for (char ch : text) {
+    set_text(w);
+    for (char ch : str()) {
         letter_mask m(ch);
         if (once.contains(m)) {
             once.remove(m);
@@ -115,7 +119,7 @@ void wordle_word::set_word_basic(const string_view &w)
     letter_mask seen;
     letter_mask seen2;
     all_mask = set_letters(all_letters); 
-    for (int i : irange((size_t)0, text.size())) {
+    for (int i : irange((size_t)0, size())) {
         char ch = text[i];
         letter_mask m(ch);
         exact_mask[i] = m;
@@ -156,11 +160,11 @@ void wordle_word::set_word_basic(const string_view &w)
 
 void wordle_word::set_word_2(const string_view &w)
 {
-    text = w;
+    set_text(w);
     exact_mask = word_mask(w);
     word_mask conflict(avx::conflict(exact_mask.get()));
     std::map<letter_mask, size_t> seen;
-    for (int i : views::iota((size_t)0, text.size()) | views::reverse) {
+    for (int i : views::iota((size_t)0, size()) | views::reverse) {
         letter_mask ch(text[i]);
         letter_mask m = conflict[i];
         size_t sz = m.size();
@@ -223,7 +227,7 @@ void wordle_word::set_word(const string_view &w)
     set_word_basic(w);
     return;
 #endif
-    text = w;
+    set_text(w);
     exact_mask = word_mask(w);
     all_letters = exact_mask.all_letters();
     auto zero(avx::zero(word_mask::mask_t()));
@@ -257,7 +261,7 @@ void wordle_word::set_word(const string_view &w)
 letter_mask wordle_word::masked_letters(match_mask mask) const
 {
     letter_mask result;
-    for (auto i : irange((size_t)0, text.size())) {
+    for (auto i : irange((size_t)0, size())) {
         if (mask.get() & (1 << i)) {
             result |= exact_mask[i];
         }
@@ -304,7 +308,7 @@ string wordle_word::groom(const string_view &w)
 styled_text wordle_word::styled_str(const match_result &mr) const
 {
     styled_text result;
-    for (size_t i : irange((size_t)0, text.size())) {
+    for (size_t i : irange((size_t)0, size())) {
         if (mr.is_exact(i)) {
             result.append(styled_text(string(1, text[i]), matched_color));
         } else if (mr.is_partial(i)) {
@@ -426,14 +430,10 @@ wordle_word::match_result wordle_word::do_match(const wordle_word &target, bool
     match_mask partial_result = partial2.to_mask();
     for (const auto *m : many_letters) {
         if (word_mask(exact).count_letter(*m)==0) {
-            word_mask wm = wordle_word::set_letters(*m);
-            U32 count = exact_mask.count_letter(*m);
-            word_mask possible_partials = wm & exact_mask;
-            word_mask target_many_mask = wordle_word::set_letters(target.many_letters);
-            word_mask p = possible_partials & target_many_mask;
-            match_mask m2 = p.to_mask();
-            match_mask m3 = m2.reduce_bitcount(count);
-            partial_result |= m2;
+            U32 target_count = target.exact_mask.count_letter(*m);
+            match_mask m2 = exact_mask.match_letter(*m);
+            partial_result &= ~m2;
+            partial_result |= m2.reduce_bitcount(target_count);
         }
     }
     letter_mask dups = repeated_letters & exact_letters;
@@ -520,25 +520,29 @@ bool wordle_word::match_result::parse(const string &m)
  *
  * The description under 'conforms' below explains the
  * algorithm. This constructor sets up the required letter and
- * word masks to allow ;conforms' to work efficiently.
+ * word masks to allow ;conforms' to work efficiently. It uses the
+ * masks the word already has, and keeps only its text, so the word
+ * can be a temporary.
  ***********************************************************************/
 
 wordle_word::match_target::match_target(const wordle_word &target, const match_result &mr)
-    : my_word(new wordle_word(target.str())), my_mr(mr)
+    : my_mr(mr)
 {
+    text_length = target.size();
+    std::copy(target.text, target.text + text_length, text);
     match_mask only_partial = my_mr.partial_match & ~my_mr.exact_match;
-    partial_letters = my_word->masked_letters(only_partial);
-    exact_letters = my_word->masked_letters(my_mr.exact_match);
+    partial_letters = target.masked_letters(only_partial);
+    exact_letters = target.masked_letters(my_mr.exact_match);
     auto x1 = partial_letters | exact_letters;
     auto x2 = ~x1;
-    absent_letters = my_word->all_letters & x2;
+    absent_letters = target.all_letters & x2;
     required_letters = partial_letters | exact_letters;
     letter_counter partial_count;
     letter_counter exact_count;
     letter_counter absent_count;
     for (size_t i : irange(0, word_length)) {
         U16 b = 1 << i;
-        char ch = my_word->text[i];
+        char ch = text[i];
         if (only_partial & b) {
             partial_count.count(ch);
             partial_mask[i] = partial_letters;
@@ -558,7 +562,7 @@ wordle_word::match_target::match_target(const wordle_word &target, const match_r
     partial_match_count = partial_count.size();
     letter_mask already_seen;
     for (size_t i : irange(0, word_length)) {
-        char ch = my_word->text[i];
+        char ch = text[i];
         if (!already_seen.contains(ch)) {
             already_seen |= ch;
             U16 pc = partial_count.get(ch);
@@ -643,8 +647,7 @@ bool wordle_word::match_target::conforms(const wordle_word &other) const
 bool wordle_word::match_target::conforms_exact(const string_view &w) const
 {
     word_mask wm(w);
-    auto em = my_word->get_exact_mask().select(my_mr.exact_match);
-    return (wm & em)==em;
+    return (wm & exact_mask)==exact_mask;
 }
 
 /************************************************************************
@@ -17,6 +17,8 @@
 
 typedef counter_map<char, U16> letter_counter;
 
+class match_view;
+
 /************************************************************************
  * match_mask - wrapper around _mmask8,providing all the obvious
  * logical operators
@@ -41,11 +43,7 @@ public:
         : my_mask(v)
     {
     }
-    match_mask &operator=(const match_mask &other)
-    {
-        my_mask = other.my_mask;
-        return *this;
-    }
+    match_mask &operator=(const match_mask &other) = default;
     match_mask &operator=(const IntegralType auto &v)
     {
         my_mask = v;
@@ -313,11 +311,7 @@ public:
             (*this)[i] = letter_mask(s[i]);
         }
     }
-    word_mask &operator=(const word_mask &other)
-    {
-        masks = other.masks;
-        return *this;
-    }
+    word_mask &operator=(const word_mask &other) = default;
     const mask_t &as_mask() const { return masks; };
     mask_t &as_mask() { return masks; };
     mask_t get() const { return masks; };
@@ -487,6 +481,43 @@ public:
         {
             return (partial_match.get() << 5) | exact_match.get();
         }
+        /************************************************************************
+         * get_code - dense base-3 encoding of the result, one digit per
+         * letter position (0 miss, 1 partial, 2 exact), lowest position
+         * first. Unlike get_hash, every value below code_count() is
+         * reachable, so 5-letter results fit in a byte.
+         ***********************************************************************/
+        U32 get_code() const
+        {
+            U32 result = 0;
+            for (int i = word_length - 1; i >= 0; --i) {
+                result = result * 3 + (is_exact(i) ? 2 : (is_partial(i) ? 1 : 0));
+            }
+            return result;
+        }
+        static match_result from_code(U32 code)
+        {
+            U16 e = 0;
+            U16 p = 0;
+            for (size_t i=0; i<word_length; ++i) {
+                U32 digit = code % 3;
+                if (digit==2) {
+                    e |= (1 << i);
+                } else if (digit==1) {
+                    p |= (1 << i);
+                }
+                code /= 3;
+            }
+            return match_result(e, p | e);
+        }
+        static U32 code_count()
+        {
+            U32 result = 1;
+            for (size_t i=0; i<word_length; ++i) {
+                result *= 3;
+            }
+            return result;
+        }
         string str() const
         {
             string result;
@@ -526,7 +557,8 @@ public:
             }
         };
     private:
-        unique_ptr<wordle_word> my_word;
+        char text[MAX_WORD_LENGTH + 1] = {};
+        U8 text_length = 0;
         match_result my_mr;
         letter_mask partial_letters;
         letter_mask exact_letters;
@@ -549,12 +581,13 @@ public:
         }
         styled_text show() const
         {
-            return my_word->styled_str(my_mr);
+            return wordle_word(str()).styled_str(my_mr);
         }
         string_view str() const
         {
-            return my_word->str();
+            return string_view(text, text_length);
         }
+    friend class ::match_view;
     };
 private:
     word_mask exact_mask;
@@ -567,7 +600,8 @@ private:
     letter_mask twice_letters;
     letter_mask many_letters;
     letter_mask repeated_letters;
-    string text;
+    char text[MAX_WORD_LENGTH + 1] = {};
+    U8 text_length = 0;
     static bool verbose;
 public:
     wordle_word()
@@ -602,24 +636,24 @@ public:
     }
     string_view str() const
     {
-        return text;
+        return string_view(text, text_length);
     }
     string explain() const;
     size_t size() const
     {
-        return text.size();
+        return text_length;
     }
     bool operator<(const wordle_word &other) const
     {
-        return text < other.text;
+        return str() < other.str();
     }
     bool operator==(const wordle_word &other) const
     {
-        return text == other.text;
+        return str() == other.str();
     }
     bool operator!=(const wordle_word &other) const
     {
-        return text != other.text;
+        return str() != other.str();
     }
     bool identical(const wordle_word &other) const;
     styled_text styled_str(const match_result &mr) const;
@@ -649,6 +683,12 @@ public:
     static string groom(const string_view &w);
     static void set_verbose(bool v) { verbose = v; };
 private:
+    void set_text(const string_view &w)
+    {
+        text_length = std::min(w.size(), size_t(MAX_WORD_LENGTH));
+        std::copy(w.begin(), w.begin() + text_length, text);
+        text[text_length] = 0;
+    }
     match_result do_match(const wordle_word &target, bool verbose) const _always_inline;
     static match_mask::mask_t to_mask(word_mask::mask_t matched)
     {